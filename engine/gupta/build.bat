@@ -35,23 +35,32 @@ set CFLAGS=%CFLAGS% ^
 windres -I src src\resource-win32\rsrc.rc resources.coff || goto :exit
 
 gcc %CFLAGS% %config% ^
--I src ^
+-I src -D _WIN32_WINNT=0x0600 ^
 src\enforce.c ^
 src\log.c ^
+src\thread.c ^
 src\uassert.c ^
 src\cecp\cecp.c ^
 src\cecp\signal.c ^
 src\cecp\stdin_io.c ^
+src\engine\bench.c ^
+src\engine\bitboard.c ^
 src\engine\board.c ^
-src\engine\delta_movement_info.c ^
+src\engine\book.c ^
 src\engine\eval.c ^
 src\engine\fen.c ^
+src\engine\file_map.c ^
 src\engine\gupta.c ^
+src\engine\material.c ^
 src\engine\move.c ^
-src\engine\move_deltas.c ^
-src\engine\piece.c ^
+src\engine\perft.c ^
 src\engine\rules.c ^
+src\engine\san.c ^
 src\engine\search.c ^
+src\engine\tablebase.c ^
+src\engine\timer.c ^
+src\engine\ttable.c ^
+src\engine\zobrist.c ^
 resources.coff ^
 -o gupta.exe || goto :exit
 
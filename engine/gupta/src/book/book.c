@@ -0,0 +1,372 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Standalone program that builds an opening book (see 'src/engine/book.c') from the games in PGN
+ * files. The first moves of every game are replayed, and each move is weighted by the result of
+ * the game for the side that played it: 2 for a win, 1 for a draw (or an unknown result), and 0
+ * for a loss. Moves without any weight are left out of the book.
+ *
+ * Usage:
+ *   gupta-book [-p PLIES] [-g GAMES] BOOK PGN...
+ *     Build the book file BOOK from the games in the PGN files. Only the first PLIES plies of
+ *     every game are used (30 by default), and only the moves that were played in at least GAMES
+ *     games (1 by default) end up in the book.
+ */
+
+#include "engine/gupta.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLIES_DEFAULT 30
+#define PLIES_MAX     100
+
+/* The longest tag or move that is read, longer ones are cut short. */
+#define TOKEN_MAX 256
+
+typedef enum
+{
+    RESULT_UNKNOWN,
+    RESULT_WHITE_WINS,
+    RESULT_BLACK_WINS,
+    RESULT_DRAW
+} result_t;
+
+/* The game being read. */
+static struct
+{
+    gupta_position_t *pos;
+
+    /* Set once the first move of the game was read. */
+    int has_started;
+
+    /* Set if a move couldn't be read, in which case the rest of the game is ignored. */
+    int is_broken;
+
+    /* From the FEN tag, if the game doesn't start from the initial position. Otherwise empty. */
+    char fen[TOKEN_MAX];
+
+    result_t result;
+
+    move_t moves[PLIES_MAX];
+    size_t num_moves;
+} game;
+
+static size_t max_plies = PLIES_DEFAULT;
+
+static gupta_book_builder_t *builder = NULL;
+
+/* Statistics, shown once the book is written. */
+static unsigned long num_games = 0,
+                     num_moves = 0,
+                     num_broken_games = 0;
+
+static unsigned int move_weight(int white_moved)
+{
+    switch (game.result)
+    {
+    case RESULT_WHITE_WINS:
+        return white_moved ? 2 : 0;
+    case RESULT_BLACK_WINS:
+        return white_moved ? 0 : 2;
+    default:
+        return 1;
+    }
+}
+
+/* Adds the moves of the game that was read to the book, now that its result is known. */
+static void end_game(void)
+{
+    int white_moved = 1;
+    size_t i;
+
+    if (!game.has_started)
+        goto done;
+
+    num_games++;
+
+    if (game.fen[0] == '\0')
+        gupta_new_game(game.pos);
+    else if (gupta_set_board_from_fen(game.pos, game.fen))
+    {
+        const char *side = strchr(game.fen, ' ');
+
+        white_moved = !side || (side[1] != 'b');
+    }
+    else
+        goto done;
+
+    for (i = 0; i < game.num_moves; i++)
+    {
+        gupta_add_book_move(builder, game.pos, &game.moves[i], move_weight(white_moved));
+        (void)gupta_make_move(game.pos, &game.moves[i]);
+        white_moved = !white_moved;
+        num_moves++;
+    }
+
+done:
+    game.has_started = 0;
+    game.is_broken = 0;
+    game.fen[0] = '\0';
+    game.result = RESULT_UNKNOWN;
+    game.num_moves = 0;
+}
+
+static void read_tag(const char *path, char *tag)
+{
+    char *value = strchr(tag, '"'),
+         *end = strrchr(tag, '"');
+
+    /* The tags come before the moves, so a game without a result has ended. */
+    if (game.has_started)
+        end_game();
+
+    if (!value || (end == value))
+    {
+        fprintf(stderr, "%s: invalid tag '[%s]'.\n", path, tag);
+        return;
+    }
+    value++;
+    *end = '\0';
+
+    if (!strncmp(tag, "FEN ", 4))
+        strcpy(game.fen, value);
+    else if (!strncmp(tag, "Result ", 7))
+    {
+        if (!strcmp(value, "1-0"))
+            game.result = RESULT_WHITE_WINS;
+        else if (!strcmp(value, "0-1"))
+            game.result = RESULT_BLACK_WINS;
+        else if (!strcmp(value, "1/2-1/2"))
+            game.result = RESULT_DRAW;
+    }
+}
+
+static void read_move(const char *path, const char *san)
+{
+    move_t move;
+
+    if (!game.has_started)
+    {
+        game.has_started = 1;
+
+        if (game.fen[0] == '\0')
+            gupta_new_game(game.pos);
+        else if (!gupta_set_board_from_fen(game.pos, game.fen))
+        {
+            fprintf(stderr, "%s: game %lu has an invalid position, '%s'.\n", path, num_games + 1,
+                    game.fen);
+            game.is_broken = 1;
+            num_broken_games++;
+        }
+    }
+
+    if (game.is_broken || (game.num_moves == max_plies))
+        return;
+
+    if (!gupta_parse_san_move(game.pos, san, &move) || !gupta_make_move(game.pos, &move))
+    {
+        fprintf(stderr, "%s: game %lu has an invalid move, '%s'.\n", path, num_games + 1, san);
+        game.is_broken = 1;
+        num_broken_games++;
+        return;
+    }
+
+    game.moves[game.num_moves++] = move;
+}
+
+/* Reads a symbol of the move text: a move number, a move, or a game termination marker. */
+static void read_symbol(const char *path, char *symbol)
+{
+    if (!strcmp(symbol, "1-0"))
+        game.result = RESULT_WHITE_WINS;
+    else if (!strcmp(symbol, "0-1"))
+        game.result = RESULT_BLACK_WINS;
+    else if (!strcmp(symbol, "1/2-1/2"))
+        game.result = RESULT_DRAW;
+    else if (strcmp(symbol, "*") != 0)
+    {
+        /* A move may be preceded by its number, as in '1.e4' and '1...e5'. Castling may be
+         * written with zeros, as in '0-0', though.
+         */
+        if (isdigit((unsigned char)symbol[0]) && strncmp(symbol, "0-0", 3))
+        {
+            symbol += strspn(symbol, "0123456789");
+            symbol += strspn(symbol, ".");
+        }
+
+        /* Numeric annotation glyphs, as in '$1', don't matter. */
+        if ((symbol[0] != '\0') && (symbol[0] != '$'))
+            read_move(path, symbol);
+        return;
+    }
+
+    /* The game termination marker. */
+    end_game();
+}
+
+/* Reads characters until 'end', or until the end of the file. */
+static void skip_until(FILE *f, int end)
+{
+    int c;
+
+    do
+        c = getc(f);
+    while ((c != end) && (c != EOF));
+}
+
+static int read_pgn(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char token[TOKEN_MAX];
+    int c;
+
+    if (!f)
+    {
+        fprintf(stderr, "Could not open '%s'.\n", path);
+        return 0;
+    }
+
+    while ((c = getc(f)) != EOF)
+    {
+        size_t len = 0;
+
+        if (isspace(c))
+            continue;
+
+        switch (c)
+        {
+        case '{':
+            /* A comment. */
+            skip_until(f, '}');
+            break;
+        case ';':
+        case '%':
+            /* A comment, or an escaped line, until the end of the line. */
+            skip_until(f, '\n');
+            break;
+        case '(':
+        {
+            /* A variation, which may contain comments and other variations. */
+            int depth = 1;
+
+            while ((depth > 0) && ((c = getc(f)) != EOF))
+            {
+                if (c == '(')
+                    depth++;
+                else if (c == ')')
+                    depth--;
+                else if (c == '{')
+                    skip_until(f, '}');
+            }
+            break;
+        }
+        case '[':
+            while (((c = getc(f)) != EOF) && (c != ']'))
+            {
+                if (len < sizeof(token) - 1)
+                    token[len++] = (char)c;
+            }
+            token[len] = '\0';
+            read_tag(path, token);
+            break;
+        default:
+            do
+            {
+                if (len < sizeof(token) - 1)
+                    token[len++] = (char)c;
+                c = getc(f);
+            } while ((c != EOF) && !isspace(c) && !strchr("{}();[]", c));
+            if (c != EOF)
+                ungetc(c, f);
+            token[len] = '\0';
+            read_symbol(path, token);
+            break;
+        }
+    }
+
+    /* The last game may lack a game termination marker. */
+    end_game();
+
+    fclose(f);
+    return 1;
+}
+
+static void show_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-p PLIES] [-g GAMES] BOOK PGN...\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int min_games = 1;
+    size_t num_entries = 0;
+    const char *book_path;
+    int i = 1,
+        r = 1;
+
+    while ((i + 1 < argc) && (argv[i][0] == '-'))
+    {
+        int value = atoi(argv[i + 1]);
+
+        if (!strcmp(argv[i], "-p") && (value >= 1) && (value <= PLIES_MAX))
+            max_plies = (size_t)value;
+        else if (!strcmp(argv[i], "-g") && (value >= 1))
+            min_games = (unsigned int)value;
+        else
+        {
+            fprintf(stderr, "Invalid option '%s %s', PLIES must be between 1 and %d, and GAMES "
+                    "at least 1.\n", argv[i], argv[i + 1], PLIES_MAX);
+            return 1;
+        }
+        i += 2;
+    }
+
+    if (argc - i < 2)
+    {
+        show_usage(argv[0]);
+        return 1;
+    }
+    book_path = argv[i++];
+
+    gupta_init();
+    game.pos = gupta_create_position();
+    builder = gupta_create_book_builder();
+
+    for (; i < argc; i++)
+    {
+        if (!read_pgn(argv[i]))
+            goto done;
+    }
+
+    if (!gupta_write_book(builder, book_path, min_games, &num_entries))
+    {
+        fprintf(stderr, "Could not write '%s'.\n", book_path);
+        goto done;
+    }
+
+    printf("%lu games (%lu with invalid moves), %lu moves, %lu book entries.\n", num_games,
+           num_broken_games, num_moves, (unsigned long)num_entries);
+    r = 0;
+
+done:
+    gupta_destroy_book_builder(builder);
+    gupta_destroy_position(game.pos);
+    gupta_uninit();
+
+    return r;
+}
@@ -31,11 +31,10 @@
 #include "common.h"
 #include "compiler_specific.h"
 #include "log.h"
+#include "thread.h"
 #include "uassert.h"
 #include "engine/gupta.h"
 
-#include <unistd.h>
-
 #ifdef _WIN32
 # include <windows.h>
 #endif /* defined(_WIN32) */
@@ -70,15 +69,49 @@ typedef struct
     /* Name of each argument. For example, the command 'sd DEPTH' has one argument name, 'DEPTH'. */
     const char *argument_names[PARSED_COMMAND_MAX_ARGUMENTS];
 
+/* What happens when the command is received while the engine is searching. In any case, the
+ * command itself is processed once the search has ended, as commands are processed in the order
+ * they were received.
+ */
+#define SEARCH_DEFER    0 /* Let the search finish. */
+#define SEARCH_MOVE_NOW 1 /* Stop the search, and play the best move found so far. */
+#define SEARCH_STOP     2 /* Stop the search, and forget about its move. */
+    int while_searching;
+
+/* What happens when the command is received while the engine is pondering or analyzing, which
+ * is done by a background (BG) search, see 'background'. Unlike during a search, commands are
+ * then processed right away, but the commands that use the position or the search first have to
+ * stop the background search.
+ */
+#define BG_KEEP 0 /* Keep the background search going. */
+#define BG_STOP 1 /* Stop it, and take back the move that was pondered on. */
+    int while_background;
+
     void (*handler)(parsed_command_t *command);
 } command_t;
 
+static void cmd_handler_analyze(parsed_command_t *command);
+static void cmd_handler_bench(parsed_command_t *command);
+static void cmd_handler_cores(parsed_command_t *command);
 static void cmd_handler_d(parsed_command_t *command);
+static void cmd_handler_divide(parsed_command_t *command);
+static void cmd_handler_easy(parsed_command_t *command);
+static void cmd_handler_exit(parsed_command_t *command);
 static void cmd_handler_force(parsed_command_t *command);
 static void cmd_handler_go(parsed_command_t *command);
+static void cmd_handler_hard(parsed_command_t *command);
 static void cmd_handler_help(parsed_command_t *command);
+static void cmd_handler_ignored(parsed_command_t *command);
+static void cmd_handler_level(parsed_command_t *command);
+static void cmd_handler_memory(parsed_command_t *command);
 static void cmd_handler_new(parsed_command_t *command);
+static void cmd_handler_nopost(parsed_command_t *command);
+static void cmd_handler_option(parsed_command_t *command);
+static void cmd_handler_otim(parsed_command_t *command);
+static void cmd_handler_perft(parsed_command_t *command);
+static void cmd_handler_period(parsed_command_t *command);
 static void cmd_handler_ping(parsed_command_t *command);
+static void cmd_handler_post(parsed_command_t *command);
 static void cmd_handler_protover(parsed_command_t *command);
 static void cmd_handler_question_mark(parsed_command_t *command);
 static void cmd_handler_quit(parsed_command_t *command);
@@ -87,6 +120,7 @@ static void cmd_handler_result(parsed_command_t *command);
 static void cmd_handler_sd(parsed_command_t *command);
 static void cmd_handler_setboard(parsed_command_t *command);
 static void cmd_handler_st(parsed_command_t *command);
+static void cmd_handler_time(parsed_command_t *command);
 static void cmd_handler_undo(parsed_command_t *command);
 static void cmd_handler_xboard(parsed_command_t *command);
 
@@ -94,16 +128,29 @@ static int cmd_arguments_to_string(char *buf, size_t size, parsed_command_t *com
                                    size_t begin_at_argument);
 
 static void msg_missing_command_argument(const char *command, const char *argument, const char *command_line);
+static void msg_unexpected_command_argument(const char *command, const char *argument,
+                                            const char *command_line);
+static int parse_level_base_time(const char *s, size_t *ms);
+static int parse_level_increment(const char *s, size_t *ms);
+static int parse_perft_depth(const char *command, const char *s, size_t *depth);
 
 static void make_and_send_move(void);
 static void send_features(void);
 static void send_result(void);
+static void send_thinking_output(gupta_search_t *s, const gupta_search_info_t *info);
 
-static void abort_and_set_move_flag(int _move_after_abortion);
 static void calculate_and_move(void);
+static void send_move(void);
+static void set_search_clock(void);
+static void ponder_hit(void);
+static void start_analysis(void);
+static int start_background_search(void);
+static void start_pondering(void);
+static void stop_background_search(void);
 static void enable_strict_mode(void);
 static int have_result(void);
 static void new_game(void);
+static int parse_can_move(move_t *m, const char *s);
 static const move_t *parse_move(const char *s);
 static int parse_and_make_move(const parsed_command_t *command);
 #ifdef CONFIG_RESIGN
@@ -112,36 +159,128 @@ static void resign(void);
 static void undo(void);
 
 static command_t command_list[] = {
-    {"d",        0,              {NULL},      cmd_handler_d},
-    {"force",    0,              {NULL},      cmd_handler_force},
-    {"go",       0,              {NULL},      cmd_handler_go},
-    {"help",     0,              {NULL},      cmd_handler_help},
-    {"new",      0,              {NULL},      cmd_handler_new},
-    {"ping",     1,              {"INTEGER"}, cmd_handler_ping},
-    {"protover", 1,              {"VERSION"}, cmd_handler_protover},
-    {"?",        0,              {NULL},      cmd_handler_question_mark},
-    {"quit",     0,              {NULL},      cmd_handler_quit},
-    {"remove",   0,              {NULL},      cmd_handler_remove},
-    {"result",   COMMAND_VARARG, {NULL},      cmd_handler_result},
-    {"sd",       1,              {"DEPTH"},   cmd_handler_sd},
-    {"setboard", COMMAND_VARARG, {NULL},      cmd_handler_setboard},
-    {"st",       1,              {"TIME"},    cmd_handler_st},
-    {"undo",     0,              {NULL},      cmd_handler_undo},
-    {"xboard",   0,              {NULL},      cmd_handler_xboard},
+    {"accepted", COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"analyze",  0,              {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_analyze},
+    {"bench",    COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_bench},
+    {"computer", COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"cores",    1,              {"N"},       SEARCH_DEFER,    BG_STOP, cmd_handler_cores},
+    {"d",        0,              {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_d},
+    {"divide",   1,              {"DEPTH"},   SEARCH_DEFER,    BG_STOP, cmd_handler_divide},
+    {"easy",     0,              {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_easy},
+    {"exit",     0,              {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_exit},
+    {"force",    0,              {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_force},
+    {"go",       0,              {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_go},
+    {"hard",     0,              {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_hard},
+    {"help",     0,              {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_help},
+    {"ics",      COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"level",    3,              {"MPS", "BASE", "INC"}, SEARCH_DEFER, BG_KEEP, cmd_handler_level},
+    {"memory",   1,              {"SIZE"},    SEARCH_DEFER,    BG_STOP, cmd_handler_memory},
+    {"name",     COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"new",      0,              {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_new},
+    {"nopost",   0,              {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_nopost},
+    {"option",   COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_option},
+    {"otim",     1,              {"N"},       SEARCH_DEFER,    BG_KEEP, cmd_handler_otim},
+    {"perft",    COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_STOP, cmd_handler_perft},
+    {".",        0,              {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_period},
+    {"ping",     1,              {"INTEGER"}, SEARCH_DEFER,    BG_KEEP, cmd_handler_ping},
+    {"post",     0,              {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_post},
+    {"protover", 1,              {"VERSION"}, SEARCH_DEFER,    BG_KEEP, cmd_handler_protover},
+    {"?",        0,              {NULL},      SEARCH_MOVE_NOW, BG_KEEP, cmd_handler_question_mark},
+    {"quit",     0,              {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_quit},
+    {"random",   COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"rating",   COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"rejected", COMMAND_VARARG, {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_ignored},
+    {"remove",   0,              {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_remove},
+    {"result",   COMMAND_VARARG, {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_result},
+    {"sd",       1,              {"DEPTH"},   SEARCH_DEFER,    BG_STOP, cmd_handler_sd},
+    {"setboard", COMMAND_VARARG, {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_setboard},
+    {"st",       1,              {"TIME"},    SEARCH_DEFER,    BG_STOP, cmd_handler_st},
+    {"time",     1,              {"N"},       SEARCH_DEFER,    BG_KEEP, cmd_handler_time},
+    {"undo",     0,              {NULL},      SEARCH_STOP,     BG_STOP, cmd_handler_undo},
+    {"xboard",   0,              {NULL},      SEARCH_DEFER,    BG_KEEP, cmd_handler_xboard},
 };
 
+/* The options that aren't search parameters, see cmd_handler_option(). */
+#define OPTION_BOOK           "Book"
+#define OPTION_BOOK_FILE      "Book file"
+#define OPTION_TABLEBASES     "Tablebases"
+#define OPTION_TABLEBASE_PATH "Tablebase path"
+
 static int quit = 0;
 
 /* When in strict mode, act according to the CECP specification. */
 static int strict_mode = 0;
 
-static int move_after_abortion = 1;
-
-static int is_searching = 0;
 static int force = 0;
 
-static int pong_queued = 0;
-static int pong_value;
+/* Set by the "hard" command, cleared by the "easy" command. */
+static int ponder = 0;
+
+/* Set by the "analyze" command, cleared by the "exit" command. */
+static int analyzing = 0;
+
+/* Set by the "post" command, cleared by the "nopost" command. As CECP requires, there is no
+ * thinking output until the "post" command is received, except while analyzing. As it is read by
+ * the background thread, it is accessed with ATOMIC_LOAD() and ATOMIC_STORE().
+ */
+static int post = 0;
+
+/* While pondering or analyzing, the search runs on the background thread (see
+ * start_background_search()), and the main thread keeps processing input. The position and the
+ * search must be left alone until the background search has stopped.
+ */
+static struct
+{
+    int is_running;
+    thread_t thread;
+
+    /* While pondering, the move that the engine expects the opponent to play, in coordinate
+     * algebraic notation, which was made before searching the position (see start_pondering()).
+     * Otherwise empty.
+     */
+    char ponder_move[8];
+} background;
+
+/* The time control set by the "level" command, and the engine's clock, as last sent by the "time"
+ * command. The times are in milliseconds. Unless a time control is set, every search takes the
+ * fixed search time instead, see the "st" command.
+ */
+static struct
+{
+    int is_set;
+    size_t moves_per_session, /* 0 means that the base time is for the whole game. */
+           increment,
+           time_left;
+} time_control;
+
+/* The progress of the search, as of the last thinking output, for the "." command. Written by the
+ * searching thread, so it is accessed with ATOMIC_LOAD() and ATOMIC_STORE().
+ */
+static struct
+{
+    size_t depth;
+    u64 nodes,
+        time;
+} search_status;
+
+/* Shared with the input reader thread (see on_input_line()), and protected by the input lock, see
+ * stdin_lock().
+ */
+static struct
+{
+    int is_searching;
+
+    /* Set when a command was received that stopped the search, see command_t. 'stop_requested'
+     * is also read by the searching thread, so it is accessed with ATOMIC_LOAD() and
+     * ATOMIC_STORE().
+     */
+    int stop_requested,
+        discard_move;
+} input_state;
+
+/* The position of the game being played, and the search that finds the engine's moves. */
+static gupta_position_t *position = NULL;
+static gupta_search_t *search = NULL;
 
 static struct
 {
@@ -160,23 +299,135 @@ static struct
     char comment[USER_COMMENT_MAX];
 } user_result;
 
+/* Sends the thinking output for a search iteration (see gupta_search_info_t): the depth, the score
+ * in centipawns, the time in centiseconds, the number of nodes, and the principal variation. As is
+ * customary, a checkmate in N moves is sent as the score 100000 + N (or -100000 - N when getting
+ * checkmated).
+ */
+static void send_thinking_output(gupta_search_t *s, const gupta_search_info_t *info)
+{
+    /* While pondering or analyzing, this is called by the background thread, so the line is
+     * written at once, such that it can't get mixed up with the output of the main thread.
+     */
+    char line[128 + GUPTA_SEARCH_DEPTH_MAX * 8];
+    int score = info->score;
+    size_t len,
+           i;
+
+    (void)s;
+
+    ATOMIC_STORE(&search_status.depth, info->depth);
+    ATOMIC_STORE(&search_status.nodes, info->nodes);
+    ATOMIC_STORE(&search_status.time, info->time);
+
+    /* 'analyzing' only changes while the background thread isn't running. */
+    if (!ATOMIC_LOAD(&post) && !analyzing)
+        return;
+
+    if (info->mate > 0)
+        score = 100000 + info->mate;
+    else if (info->mate < 0)
+        score = -100000 + info->mate;
+
+    len = (size_t)sprintf(line, "%u %d %llu %llu", (unsigned int)info->depth, score,
+                          info->time / 10, info->nodes);
+    for (i = 0; i < info->pv_length; i++)
+        len += (size_t)sprintf(&line[len], " %s", gupta_move_to_can(&info->pv[i]));
+
+    printf("%s\n", line);
+}
+
+static void cmd_handler_analyze(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
+
+    /* The analysis starts once this command has been processed, see process_input(). */
+    analyzing = 1;
+}
+
+static void cmd_handler_bench(parsed_command_t *command)
+{
+    int depth = 0;
+
+    if (command->num_arguments > 1)
+    {
+        msg_unexpected_command_argument(command->command, command->arguments[1],
+                                        command->command_line);
+        return;
+    }
+
+    if (command->num_arguments == 1)
+    {
+        depth = atoi(command->arguments[0]);
+        if ((depth < 1) || (depth > GUPTA_SEARCH_DEPTH_MAX))
+        {
+            printf("Invalid depth '%s' for command '%s', must be between 1 and %d.\n",
+                   command->arguments[0], command->command, GUPTA_SEARCH_DEPTH_MAX);
+            return;
+        }
+    }
+
+    gupta_bench(search, (size_t)depth);
+}
+
+static void cmd_handler_cores(parsed_command_t *command)
+{
+    int cores;
+
+    UASSERT(command->num_arguments == 1);
+
+    cores = atoi(command->arguments[0]);
+    if ((cores < 1) || (cores > GUPTA_SEARCH_THREADS_MAX))
+    {
+        printf("Invalid number of cores '%s' for command '%s', must be between 1 and %d.\n",
+               command->arguments[0], command->command, GUPTA_SEARCH_THREADS_MAX);
+        return;
+    }
+
+    gupta_set_search_threads(search, (size_t)cores);
+}
+
 static void cmd_handler_d(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
-    gupta_show_board();
+    gupta_show_board(position);
+}
+
+static void cmd_handler_divide(parsed_command_t *command)
+{
+    size_t depth;
+
+    UASSERT(command->num_arguments == 1);
+
+    if (parse_perft_depth(command->command, command->arguments[0], &depth))
+        gupta_show_perft(position, depth, 1);
+}
+
+static void cmd_handler_easy(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
+
+    /* Any pondering has already been stopped, see BG_STOP. */
+    ponder = 0;
+}
+
+static void cmd_handler_exit(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
+
+    /* The analysis has already been stopped, see BG_STOP. */
+    analyzing = 0;
 }
 
 static void cmd_handler_force(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
-    /* The CECP specification says nothing about toggling, so just always enable force mode. */
+    /* The CECP specification says nothing about toggling, so just always enable force mode. The
+     * CECP specification also mandates that the engine stops searching, see SEARCH_STOP.
+     */
     force = 1;
-
-    /* The CECP specification mandates that the engine stops searching. */
-    if (is_searching)
-        abort_and_set_move_flag(0);
 }
 
 static void cmd_handler_go(parsed_command_t *command)
@@ -186,32 +437,142 @@ static void cmd_handler_go(parsed_command_t *command)
     calculate_and_move();
 }
 
+static void cmd_handler_hard(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
+
+    /* Pondering starts after the engine's next move. */
+    ponder = 1;
+}
+
 static void cmd_handler_help(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
     /* TODO XXX: keep this up-to-date */
     printf("\
+.                       In analysis mode, show the progress of the analysis.\n\
 ?                       If calculating, ask engine to move immediately.\n\
+analyze                 Analyze the position until 'exit', following the moves\n\
+                        that are entered.\n\
+bench [DEPTH]           Search a set of positions to DEPTH plies, and show the\n\
+                        speed and a signature of the node counts.\n\
+cores N                 Use N threads for searching.\n\
 d                       Display the board.\n\
+divide DEPTH            Like 'perft DEPTH', but also show the count for each move.\n\
+easy                    Don't ponder.\n\
+exit                    Leave analysis mode.\n\
 force                   Don't automatically move, wait for the user to ask the\n\
                         engine to move.\n\
+");
+    printf("\
 go                      Ask engine to move.\n\
+hard                    Ponder: think about the expected reply on the\n\
+                        opponent's time.\n\
 help                    Display this information.\n\
+level MPS BASE INC      Play MPS moves (0 for all moves) in BASE minutes (or\n\
+                        MIN:SEC), plus INC seconds for every move.\n\
+memory SIZE             Set the size of the hash table to SIZE megabytes.\n\
 new                     Start a new game.\n\
+nopost                  Don't show thinking output.\n\
+");
+    printf("\
+option NAME=VALUE       Set the search parameter NAME to VALUE. The option\n\
+                        'Book' (0 or 1) sets whether to play book moves,\n\
+                        'Book file' which opening book to use, 'Tablebases'\n\
+                        (0 or 1) whether to use the endgame tablebases, and\n\
+                        'Tablebase path' the directory that holds them.\n\
+otim N                  Set the opponent's clock to N centiseconds.\n\
+perft [DEPTH]           Count the positions DEPTH plies deep, and show the speed.\n\
+                        Without DEPTH, run the built-in suite of perft positions.\n\
+post                    Show thinking output.\n\
 quit                    Quit the program.\n\
 remove                  Undo last move (two plies).\n\
 ");
     printf("\
 sd DEPTH                Set the maximum search depth to DEPTH plies.\n\
 setboard FEN            Set the board to the state expressed by the FEN string.\n\
-st TIME                 Set the maximum search time to TIME seconds.\n\
+st TIME                 Set the maximum search time to TIME seconds (fractions allowed).\n\
+time N                  Set the engine's clock to N centiseconds.\n\
 undo                    Undo last half-move (one ply).\n\
 xboard                  Put engine in CECP mode if not already.\n\
                         (CECP = Chess Engine Communication Protocol)\n\
 ");
 }
 
+static void cmd_handler_ignored(parsed_command_t *command)
+{
+    /* The chess interface informs the engine about the opponent, the ICS, and whether a feature
+     * was accepted, none of which matters to this engine. These commands are accepted all the
+     * same, as otherwise they would be reported as unknown, and would stop any pondering, see
+     * BG_KEEP.
+     */
+    (void)command;
+}
+
+static void cmd_handler_level(parsed_command_t *command)
+{
+    int moves_per_session;
+    size_t base_time,
+           increment;
+
+    UASSERT(command->num_arguments == 3);
+
+    /* For example 'level 40 5 0' (40 moves in 5 minutes), or 'level 0 2:30 1.5' (the whole game
+     * in 2 minutes and 30 seconds, plus 1.5 seconds for every move).
+     */
+    moves_per_session = atoi(command->arguments[0]);
+    if ((moves_per_session < 0) || !parse_level_base_time(command->arguments[1], &base_time) ||
+        !parse_level_increment(command->arguments[2], &increment))
+    {
+        if (strict_mode)
+            printf("Error (invalid time control): %s\n", command->command_line);
+        else
+            printf("Invalid time control '%s'.\n", command->command_line);
+        return;
+    }
+
+    time_control.is_set = 1;
+    time_control.moves_per_session = (size_t)moves_per_session;
+    time_control.increment = increment;
+
+    /* Until the "time" command says otherwise. */
+    time_control.time_left = base_time;
+}
+
+static void cmd_handler_memory(parsed_command_t *command)
+{
+    const char *size = command->arguments[0];
+    char *end;
+    unsigned long megabytes;
+
+    UASSERT(command->num_arguments == 1);
+
+    /* strtoul() would accept a sign, and negate the number if it's a minus sign. */
+    errno = 0;
+    megabytes = strtoul(size, &end, 10);
+    if ((size[0] < '0') || (size[0] > '9') || (*end != '\0') || (errno == ERANGE) ||
+        (megabytes > GUPTA_HASH_SIZE_MAX))
+    {
+        if (strict_mode)
+            printf("Error (invalid size): %s\n", command->command_line);
+        else
+        {
+            printf("Invalid hash table size '%s', must be between 0 and %lu megabytes.\n", size,
+                   (unsigned long)GUPTA_HASH_SIZE_MAX);
+        }
+        return;
+    }
+
+    if (!gupta_set_hash_size((size_t)megabytes))
+    {
+        if (strict_mode)
+            printf("Error (out of memory): %s\n", command->command_line);
+        else
+            printf("Could not allocate a hash table of %s megabytes.\n", command->arguments[0]);
+    }
+}
+
 static void cmd_handler_new(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
@@ -219,22 +580,140 @@ static void cmd_handler_new(parsed_command_t *command)
     new_game();
 }
 
-static void cmd_handler_undo(parsed_command_t *command)
+static void cmd_handler_nopost(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
-    if (is_searching)
-        abort_and_set_move_flag(1);
+    ATOMIC_STORE(&post, 0);
+}
+
+static void cmd_handler_option(parsed_command_t *command)
+{
+    char option[PARSED_COMMAND_MAX_SIZE];
+    char *value;
+
+    if (command->num_arguments == 0)
+    {
+        msg_missing_command_argument(command->command, "NAME=VALUE", command->command_line);
+        return;
+    }
+
+    /* The option name may contain spaces, so it was split into several arguments. */
+    if (!cmd_arguments_to_string(option, ARRAY_SIZE(option), command, 0))
+    {
+        printf("Option in the line '%s' is too long, no space in the option buffer.\n",
+               command->command_line);
+        return;
+    }
+
+    value = strchr(option, '=');
+    if (!value)
+    {
+        printf("Invalid value '%s' for NAME=VALUE argument to command '%s'.\n", option,
+               command->command);
+        return;
+    }
+    *value++ = '\0';
+
+    if (!strcmp(option, OPTION_BOOK))
+        gupta_set_search_book(search, atoi(value));
+    else if (!strcmp(option, OPTION_BOOK_FILE))
+    {
+        /* Any book that was open is closed regardless. */
+        if (!gupta_open_book(value))
+        {
+            if (strict_mode)
+                printf("Error (cannot open book): %s\n", command->command_line);
+            else
+                printf("Could not open the book '%s'.\n", value);
+        }
+    }
+    else if (!strcmp(option, OPTION_TABLEBASES))
+        gupta_set_search_tablebases(search, atoi(value));
+    else if (!strcmp(option, OPTION_TABLEBASE_PATH))
+    {
+        /* Any tablebases that were open are closed regardless. */
+        if (gupta_open_tablebases(value) == 0)
+        {
+            if (strict_mode)
+                printf("Error (cannot open tablebases): %s\n", command->command_line);
+            else
+                printf("Could not open any tablebases in '%s'.\n", value);
+        }
+    }
+    else if (!gupta_set_search_param(option, atoi(value)))
+    {
+        if (strict_mode)
+            printf("Error (invalid option): %s\n", command->command_line);
+        else
+            printf("Unknown option '%s', or invalid value '%s'.\n", option, value);
+    }
+}
+
+static void cmd_handler_otim(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 1);
+
+    /* The opponent's clock is of no concern, the engine budgets its time from its own clock. */
+}
+
+static void cmd_handler_undo(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
 
     undo();
 }
 
+static void cmd_handler_perft(parsed_command_t *command)
+{
+    size_t depth;
+
+    if (command->num_arguments > 1)
+    {
+        msg_unexpected_command_argument(command->command, command->arguments[1],
+                                        command->command_line);
+        return;
+    }
+
+    if (command->num_arguments == 1)
+    {
+        if (parse_perft_depth(command->command, command->arguments[0], &depth))
+            gupta_show_perft(position, depth, 0);
+        return;
+    }
+
+    (void)gupta_run_perft_suite(0);
+}
+
+static void cmd_handler_period(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
+
+    /* Only used in analysis mode, to ask for the progress of the analysis. The number of moves
+     * left to search and the total number of moves aren't tracked, so both are sent as zero.
+     */
+    if (!analyzing)
+        return;
+
+    printf("stat01: %llu %llu %u 0 0\n", ATOMIC_LOAD(&search_status.time) / 10,
+           ATOMIC_LOAD(&search_status.nodes), (unsigned int)ATOMIC_LOAD(&search_status.depth));
+}
+
 static void cmd_handler_ping(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 1);
 
-    pong_queued = 1;
-    pong_value = atoi(command->arguments[0]);
+    /* All the input that was received before the "ping" command has been processed by now, as
+     * commands are processed in order, and never while searching.
+     */
+    printf("pong %d\n", atoi(command->arguments[0]));
+}
+
+static void cmd_handler_post(parsed_command_t *command)
+{
+    UASSERT(command->num_arguments == 0);
+
+    ATOMIC_STORE(&post, 1);
 }
 
 static void cmd_handler_protover(parsed_command_t *command)
@@ -261,18 +740,15 @@ static void cmd_handler_question_mark(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
-    if (is_searching)
-        abort_and_set_move_flag(1);
+    /* The search was already stopped when this command was received (see SEARCH_MOVE_NOW), so
+     * there is nothing left to do.
+     */
 }
 
 static void cmd_handler_quit(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
-    /* Guarantee a speedy exit, regardless of whether the engine is searching. */
-    if (is_searching)
-        abort_and_set_move_flag(0);
-
     quit = 1;
 }
 
@@ -280,9 +756,6 @@ static void cmd_handler_remove(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 0);
 
-    if (is_searching)
-        abort_and_set_move_flag(1);
-
     /* We call undo() twice intentionally, to undo the last two plies. */
     undo();
     undo();
@@ -367,7 +840,7 @@ static void cmd_handler_sd(parsed_command_t *command)
 {
     UASSERT(command->num_arguments == 1);
 
-    gupta_set_search_depth(atoi(command->arguments[0]));
+    gupta_set_search_depth(search, atoi(command->arguments[0]));
 }
 
 static void cmd_handler_setboard(parsed_command_t *command)
@@ -388,7 +861,7 @@ static void cmd_handler_setboard(parsed_command_t *command)
         return;
     }
 
-    if (!gupta_set_board_from_fen(fen))
+    if (!gupta_set_board_from_fen(position, fen))
     {
         /* When an invalid FEN string was passed to gupta_set_board_from_fen(), the game may have
          * been reset (as if a new game was started). See gupta_set_board_from_fen() for more
@@ -423,9 +896,35 @@ static void cmd_handler_setboard(parsed_command_t *command)
 
 static void cmd_handler_st(parsed_command_t *command)
 {
+    double seconds;
+
     UASSERT(command->num_arguments == 1);
 
-    gupta_set_search_time(atoi(command->arguments[0]));
+    /* A fixed search time replaces any time control. */
+    time_control.is_set = 0;
+
+    /* The search time may be given with a fractional part, as in 'st 0.5'. */
+    seconds = strtod(command->arguments[0], NULL);
+    if (seconds <= 0)
+    {
+        /* Select the default search time. */
+        gupta_set_search_time(search, 0);
+    }
+    else if (seconds < 0.001)
+        gupta_set_search_time(search, 1);
+    else
+        gupta_set_search_time(search, (size_t)(seconds * 1000 + 0.5));
+}
+
+static void cmd_handler_time(parsed_command_t *command)
+{
+    long centiseconds;
+
+    UASSERT(command->num_arguments == 1);
+
+    /* The time is negative once the engine has lost on time, but the game may go on regardless. */
+    centiseconds = atol(command->arguments[0]);
+    time_control.time_left = (centiseconds > 0) ? (size_t)centiseconds * 10 : 0;
 }
 
 static void cmd_handler_xboard(parsed_command_t *command)
@@ -463,6 +962,70 @@ static void msg_unexpected_command_argument(const char *command, const char *arg
     }
 }
 
+/* Parses the base time of the "level" command, which is either in minutes or in minutes and
+ * seconds, as in '5' or '0:30', into milliseconds. Returns 0 if the base time is invalid.
+ */
+static int parse_level_base_time(const char *s, size_t *ms)
+{
+    char *end;
+    double minutes,
+           seconds = 0;
+
+    minutes = strtod(s, &end);
+    if ((end == s) || (minutes < 0))
+        return 0;
+
+    if (*end == ':')
+    {
+        s = end + 1;
+        seconds = strtod(s, &end);
+        if ((end == s) || (seconds < 0))
+            return 0;
+    }
+
+    if (*end != '\0')
+        return 0;
+
+    *ms = (size_t)((minutes * 60 + seconds) * 1000 + 0.5);
+    return 1;
+}
+
+/* Parses the increment of the "level" command, in seconds (fractions allowed), into milliseconds.
+ * Returns 0 if the increment is invalid. An increment of more than a million seconds makes no
+ * sense, and might not fit into 'ms'.
+ */
+static int parse_level_increment(const char *s, size_t *ms)
+{
+    char *end;
+    double seconds;
+
+    seconds = strtod(s, &end);
+    /* Written so that NaN is rejected as well. */
+    if ((end == s) || (*end != '\0') || !((seconds >= 0) && (seconds <= 1e6)))
+        return 0;
+
+    *ms = (size_t)(seconds * 1000 + 0.5);
+    return 1;
+}
+
+/* Parses the DEPTH argument of the perft commands. Returns 1 on success, or 0 (after showing a
+ * message) if the depth is invalid.
+ */
+static int parse_perft_depth(const char *command, const char *s, size_t *depth)
+{
+    int n = atoi(s);
+
+    if ((n < 0) || (n > GUPTA_SEARCH_DEPTH_MAX))
+    {
+        printf("Invalid depth '%s' for command '%s', must be between 0 and %d.\n", s, command,
+               GUPTA_SEARCH_DEPTH_MAX);
+        return 0;
+    }
+
+    *depth = (size_t)n;
+    return 1;
+}
+
 static void msg_command_buffer_space_exhausted(const char *token, size_t token_size,
                                                const char *command_line)
 {
@@ -605,16 +1168,81 @@ static int parse_command_line(parsed_command_t *command, const char *command_lin
     UASSERT(0);
 }
 
+/* Returns the command named by the first 'len' characters of 'name', or NULL if there is none. */
+static const command_t *find_command(const char *name, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(command_list); i++)
+    {
+        if ((strlen(command_list[i].command) == len) &&
+            (strncmp(command_list[i].command, name, len) == 0))
+        {
+            return &command_list[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Returns what happens when the command on line 'line' is received while searching, see
+ * command_t. Anything that is not a known command, such as a move, stops the search.
+ */
+static int command_while_searching(const char *line)
+{
+    const command_t *command;
+    size_t begin,
+           end;
+
+    for (begin = 0; line[begin] == ' '; begin++)
+        ;
+    for (end = begin; (line[end] != ' ') && (line[end] != '\n') && (line[end] != '\0'); end++)
+        ;
+
+    /* Empty lines are ignored. */
+    if (end == begin)
+        return SEARCH_DEFER;
+
+    command = find_command(&line[begin], end - begin);
+    return command ? command->while_searching : SEARCH_STOP;
+}
+
+/* Called by the input reader thread for every line it queues, and with NULL once the input has
+ * ended, see stdin_start_reader(). The lines are only processed by the main thread, but this lets
+ * a line that must stop the search do so right away, by setting the stop flag that the search
+ * polls.
+ */
+static void on_input_line(const char *line)
+{
+    if (!input_state.is_searching)
+        return;
+
+    switch (line ? command_while_searching(line) : SEARCH_STOP)
+    {
+    case SEARCH_DEFER:
+        return;
+    case SEARCH_MOVE_NOW:
+        break;
+    case SEARCH_STOP:
+        input_state.discard_move = 1;
+        break;
+    }
+
+    ATOMIC_STORE(&input_state.stop_requested, 1);
+    gupta_abort_search(search);
+}
+
 static int process_input(void)
 {
-#define COMMAND_LINE_MAX 1024
-    static char      command_line[COMMAND_LINE_MAX];
+    static char      command_line[STDIN_LINE_MAX];
     parsed_command_t command;
-    size_t           i,
-                     len;
+    const command_t  *found;
+    move_t           move;
+    size_t           len;
     int              r;
 
-    r = stdin_is_data_avail();
+    /* Blocks until there is input. */
+    r = stdin_read_line(command_line, sizeof(command_line));
     if (r < 0)
     {
         if (errno == STDIN_EEOF)
@@ -622,16 +1250,6 @@ static int process_input(void)
         else
             return 0;
     }
-    else if (r == 0)
-        return 1;
-
-    if (fgets(command_line, sizeof(command_line), stdin) == NULL)
-    {
-        if (feof(stdin))
-            goto quit;
-        else
-            return 0;
-    }
 
     /* TODO remove at some point */
     do_log("incoming data: [%s]\n", command_line);
@@ -649,34 +1267,55 @@ static int process_input(void)
     if (!parse_command_line(&command, command_line))
         return 1;
 
-    for (i = 0; i < ARRAY_SIZE(command_list); i++)
+    found = find_command(command.command, strlen(command.command));
+
+    if (background.is_running)
     {
-        if (strcmp(command_list[i].command, command.command) == 0)
+        /* If the opponent played the expected move, the pondering turns into the search for the
+         * engine's reply.
+         */
+        if (!found && (background.ponder_move[0] != '\0'))
         {
-            int ok = 0;
-
-            if (command_list[i].num_arguments == COMMAND_VARARG)
-                ok = 1;
-            else if (command.num_arguments < command_list[i].num_arguments)
-            {
-                msg_missing_command_argument(command.command,
-                                             command_list[i].argument_names[command.num_arguments],
-                                             command_line);
-            }
-            else if (command.num_arguments > command_list[i].num_arguments)
+            /* Only a move in coordinate algebraic notation is recognized here, as a SAN move can
+             * only be read in the position before the move that was pondered on.
+             */
+            if (parse_can_move(&move, command.command) &&
+                (strcmp(gupta_move_to_can(&move), background.ponder_move) == 0))
             {
-                msg_unexpected_command_argument(command.command,
-                                                command.arguments[command_list[i].num_arguments],
-                                                command_line);
+                ponder_hit();
+                goto done;
             }
-            else
-                ok = 1;
+        }
+
+        if (!found || (found->while_background == BG_STOP))
+            stop_background_search();
+    }
 
-            if (ok)
-                command_list[i].handler(&command);
+    if (found)
+    {
+        int ok = 0;
 
-            goto done;
+        if (found->num_arguments == COMMAND_VARARG)
+            ok = 1;
+        else if (command.num_arguments < found->num_arguments)
+        {
+            msg_missing_command_argument(command.command,
+                                         found->argument_names[command.num_arguments],
+                                         command_line);
         }
+        else if (command.num_arguments > found->num_arguments)
+        {
+            msg_unexpected_command_argument(command.command,
+                                            command.arguments[found->num_arguments],
+                                            command_line);
+        }
+        else
+            ok = 1;
+
+        if (ok)
+            found->handler(&command);
+
+        goto done;
     }
 
     /* If the command wasn't handled, try to parse it as a move, but only if we have no game
@@ -686,21 +1325,14 @@ static int process_input(void)
         send_result();
     else if (parse_and_make_move(&command))
     {
-        if (!force)
+        if (!force && !analyzing)
             calculate_and_move();
     }
 
 done:
-    /* Only send a pong when not searching and all the input that was received before the "ping"
-     * command has been processed. Remember, due to the search interrupt mechanism, *this* function
-     * recurses: calculate_and_move() calls gupta_find_move(), which calls search(), which calls
-     * the search interrupt callback that was set using gupta_set_search_interrupt().
-     */
-    if (!is_searching && pong_queued)
-    {
-        printf("pong %d\n", pong_value);
-        pong_queued = 0;
-    }
+    /* The analysis carries on with whatever position the command left behind. */
+    if (analyzing && !background.is_running && !quit)
+        start_analysis();
 
     return 1;
 
@@ -718,23 +1350,19 @@ static int loop(void)
         r = process_input();
         if (!r)
             return 0;
-
-        /* Sleep when the engine is not calculating, in order to save at least most of the
-         * unnecessarily consumed CPU time.
-         */
-        usleep(1000);
     }
 
     return 1;
 }
 
-static void interrupt(void)
+/* Input is never processed while searching, on_input_line() stops the search instead. But a stop
+ * that was requested right before the search started may have been undone by the search, as it
+ * clears its stop flag when starting, so it is applied again here.
+ */
+static void interrupt(gupta_search_t *s)
 {
-    if (!process_input() ||
-        quit /* 'quit' may be set by process_input() */)
-    {
-        gupta_abort_search();
-    }
+    if (ATOMIC_LOAD(&input_state.stop_requested))
+        gupta_abort_search(s);
 }
 
 static void make_and_send_move()
@@ -742,12 +1370,12 @@ static void make_and_send_move()
     const move_t *move;
     const char *move_str;
 
-    move = gupta_get_best_move();
+    move = gupta_get_best_move(search);
     UASSERT(move);
     move_str = gupta_move_to_can(move);
     UASSERT(move_str);
 
-    if (!gupta_make_move(move))
+    if (!gupta_make_move(position, move))
         UASSERT(0);
 
     if (strict_mode)
@@ -755,23 +1383,40 @@ static void make_and_send_move()
     else
         printf("Engine move: %s\n", move_str);
 
-    if (gupta_is_game_over(NULL))
+    if (gupta_is_game_over(position, NULL))
         send_result();
 }
 
 static void send_features()
 {
+    size_t i;
+
     /* TODO XXX make sure that we indeed support all the features that we claim to support */
     printf("feature ping=1 setboard=1 playother=1 nps=0\n");
     printf("feature time=1 draw=1\n");
     printf("feature sigint=0 sigterm=0\n");
-    /* TODO *'analysis'* When analysis mode is supported, send 'analyze=1' instead of 'analyze=0'.
-     *                   Perhaps also support 'nps', and change the above 'nps=0' to 'nps=1'.
-     */
-    printf("feature reuse=1 analyze=0\n");
+    printf("feature memory=1 smp=1\n");
+    /* TODO Perhaps support 'nps', and change the above 'nps=0' to 'nps=1'. */
+    printf("feature reuse=1 analyze=1\n");
     printf("feature name=1 myname=\"Gupta\"\n");
     printf("feature variants=\"normal\"\n");
     printf("feature colors=0\n");
+    printf("feature option=\"%s -check %d\"\n", OPTION_BOOK, gupta_get_search_book(search));
+    printf("feature option=\"%s -file %s\"\n", OPTION_BOOK_FILE, GUPTA_BOOK_FILE_DEFAULT);
+    printf("feature option=\"%s -check %d\"\n", OPTION_TABLEBASES,
+           gupta_get_search_tablebases(search));
+    printf("feature option=\"%s -path %s\"\n", OPTION_TABLEBASE_PATH,
+           GUPTA_TABLEBASE_PATH_DEFAULT);
+    for (i = 0; i < gupta_get_num_search_params(); i++)
+    {
+        const gupta_search_param_t *param = gupta_get_search_param(i);
+
+        if (param->is_boolean)
+            printf("feature option=\"%s -check %d\"\n", param->name, param->value);
+        else
+            printf("feature option=\"%s -spin %d %d %d\"\n", param->name, param->value,
+                   param->min, param->max);
+    }
     printf("feature done=1\n");
 }
 
@@ -785,7 +1430,7 @@ static void send_result()
         return;
     }
 
-    if (!gupta_is_game_over(&result))
+    if (!gupta_is_game_over(position, &result))
         UASSERT(0 && "Expected a game result but there was none.");
 
     switch (result)
@@ -824,20 +1469,45 @@ static void send_result()
     }
 }
 
-static void abort_and_set_move_flag(int _move_after_abortion)
+/* Marks the start of a search during which input may be received, see on_input_line(). Returns 0
+ * if input that was received before the search started already stopped it.
+ */
+static int begin_search(void)
 {
-    gupta_abort_search();
-    move_after_abortion = _move_after_abortion;
+    int discard_move;
+
+    stdin_lock();
+    input_state.is_searching = 1;
+    ATOMIC_STORE(&input_state.stop_requested, 0);
+    input_state.discard_move = 0;
+    /* The input that is waiting to be processed was received before the search started, but it
+     * affects the search just the same.
+     */
+    stdin_scan_queued_lines(on_input_line);
+    discard_move = input_state.discard_move;
+    stdin_unlock();
+
+    return !discard_move;
 }
 
-static void calculate_and_move()
+/* Marks the end of a search that was started with begin_search(). Returns 0 if the search was
+ * stopped by a command such as "force" or "quit", which is processed next, and which makes the move
+ * of the search meaningless.
+ */
+static int end_search(void)
 {
-    if (is_searching)
-    {
-        do_log("Warning: got a request to search but the program was already searching.\n");
-        return;
-    }
+    int discard_move;
+
+    stdin_lock();
+    input_state.is_searching = 0;
+    discard_move = input_state.discard_move;
+    stdin_unlock();
+
+    return !discard_move;
+}
 
+static void calculate_and_move()
+{
     /* If the game is over, don't ask the engine to search for a move, just re-emit the result. */
     if (have_result())
     {
@@ -852,24 +1522,19 @@ static void calculate_and_move()
      */
     force = 0;
 
-    is_searching = 1;
-    gupta_find_move();
-    is_searching = 0;
+    set_search_clock();
+    if (begin_search())
+        gupta_find_move(search, position);
 
-    /* If the search was aborted because we were requested to quit, then quit immediately,
-     * don't send any move.
-     */
-    if (quit)
-        return;
-
-    if (!move_after_abortion)
-    {
-        move_after_abortion = 1;
-        return;
-    }
+    if (end_search())
+        send_move();
+}
 
+/* Plays and sends the move found by the search, and starts pondering on the opponent's time. */
+static void send_move()
+{
 #ifdef CONFIG_RESIGN
-    if (gupta_is_resignation_sensible())
+    if (gupta_is_resignation_sensible(search))
         resign();
     else
 #endif /* defined(CONFIG_RESIGN) */
@@ -878,7 +1543,154 @@ static void calculate_and_move()
     }
 
     if (!strict_mode)
-        gupta_show_board();
+        gupta_show_board(position);
+
+    if (ponder && !analyzing && !have_result())
+        start_pondering();
+}
+
+/* When playing on a clock, tells the search how much time the engine has left for the moves until
+ * the next time control. The moves are counted from the start of the game (or from the position
+ * that was set up), in which the engine made half of the moves, rounded down, when it's its turn.
+ */
+static void set_search_clock()
+{
+    size_t moves_to_go = 0;
+
+    if (!time_control.is_set)
+        return;
+
+    if (time_control.moves_per_session)
+    {
+        moves_to_go = time_control.moves_per_session -
+                      (gupta_get_num_moves_made(position) / 2) % time_control.moves_per_session;
+    }
+
+    gupta_set_search_clock(search, time_control.time_left, time_control.increment, moves_to_go);
+}
+
+static void background_thread(void *arg)
+{
+    (void)arg;
+
+    gupta_find_move(search, position);
+}
+
+/* Starts searching the position on the background thread, without regard to the search time,
+ * until stop_background_search() is called. Returns 0 if the thread couldn't be started.
+ */
+static int start_background_search()
+{
+    UASSERT(!background.is_running);
+
+    /* The input isn't watched during a background search, see on_input_line(), so no stop
+     * request can be left over from an earlier search.
+     */
+    stdin_lock();
+    ATOMIC_STORE(&input_state.stop_requested, 0);
+    stdin_unlock();
+
+    gupta_set_search_pondering(search, 1);
+    if (!thread_create(&background.thread, background_thread, NULL))
+    {
+        gupta_set_search_pondering(search, 0);
+        return 0;
+    }
+
+    background.is_running = 1;
+    return 1;
+}
+
+/* Stops the background search, and takes back the move that was pondered on, if any. */
+static void stop_background_search()
+{
+    UASSERT(background.is_running);
+
+    /* The stop request is in case the background thread hadn't even started searching yet, see
+     * interrupt().
+     */
+    stdin_lock();
+    ATOMIC_STORE(&input_state.stop_requested, 1);
+    stdin_unlock();
+    gupta_abort_search(search);
+
+    thread_join(&background.thread);
+    background.is_running = 0;
+
+    if (background.ponder_move[0] != '\0')
+    {
+        background.ponder_move[0] = '\0';
+        gupta_undo_move(position);
+    }
+}
+
+/* Starts pondering, if the search that found the engine's move expects a reply. */
+static void start_pondering()
+{
+    const move_t *move;
+
+    move = gupta_get_ponder_move(search);
+    if (!move)
+        return;
+
+    strcpy(background.ponder_move, gupta_move_to_can(move));
+    if (!gupta_make_move(position, move))
+    {
+        UASSERT(0 && "The expected reply is illegal.");
+        background.ponder_move[0] = '\0';
+        return;
+    }
+
+    /* The time limits only apply after a ponder hit, at which point they are set again from the
+     * clock as it is then, see ponder_hit().
+     */
+    set_search_clock();
+
+    /* Pondering on a move that ends the game is pointless. */
+    if (gupta_is_game_over(position, NULL) || !start_background_search())
+    {
+        background.ponder_move[0] = '\0';
+        gupta_undo_move(position);
+    }
+}
+
+/* The opponent played the move that was pondered on, so the pondering search carries on as the
+ * search for the engine's reply. The time spent pondering counts as search time. The search
+ * budgets its time from the clock as the "time" command that came with the opponent's move left
+ * it, as that accounts for the time the engine spent on its previous move.
+ */
+static void ponder_hit()
+{
+    UASSERT(background.is_running && (background.ponder_move[0] != '\0'));
+
+    if (begin_search())
+    {
+        set_search_clock();
+        gupta_ponderhit(search);
+    }
+
+    /* The pondering search may even be done already, for example when it found a checkmate. */
+    thread_join(&background.thread);
+    background.is_running = 0;
+    background.ponder_move[0] = '\0';
+
+    if (end_search())
+        send_move();
+}
+
+/* Starts analyzing the position, unless the game is over. The analysis only ends once the
+ * background search is stopped, see process_input().
+ */
+static void start_analysis()
+{
+    if (have_result())
+        return;
+
+    ATOMIC_STORE(&search_status.depth, 0);
+    ATOMIC_STORE(&search_status.nodes, 0);
+    ATOMIC_STORE(&search_status.time, 0);
+
+    (void)start_background_search();
 }
 
 static void enable_strict_mode()
@@ -902,7 +1714,7 @@ static int have_result()
     if (user_result.valid)
         return 1;
 
-    return gupta_is_game_over(&result);
+    return gupta_is_game_over(position, &result);
 }
 
 static void new_game()
@@ -916,14 +1728,19 @@ static void new_game()
     /* The CECP specification mandates that the search depth be set to unlimited when a new game
      * is started.
      */
-    gupta_set_search_depth(GUPTA_SEARCH_DEPTH_MAX);
+    gupta_set_search_depth(search, GUPTA_SEARCH_DEPTH_MAX);
 
     /* The CECP specification mandates that the time controls be reset when a new game is
      * started.
      */
-    gupta_set_search_time(GUPTA_SEARCH_TIME_DEFAULT);
+    time_control.is_set = 0;
+    gupta_set_search_time(search, GUPTA_SEARCH_TIME_DEFAULT);
+
+    gupta_new_game(position);
 
-    gupta_new_game();
+    /* What was learned during the previous game is of no use anymore. */
+    gupta_clear_hash();
+    gupta_clear_search(search);
 }
 
 static int parse_can_move(move_t *m, const char *s)
@@ -975,20 +1792,7 @@ static int parse_can_move(move_t *m, const char *s)
 
 static int parse_san_move(move_t *m, const char *s)
 {
-    (void)m;(void)s;
-    /* TODO: implement, and test if the parser works for these moves:
-        e4
-        e4+
-        dxc4
-        dxc4+
-        e8=Q
-        e8=Q+
-        gxh8=Q
-        gxh8=Q+
-        g8Q+ (another notation for a pawn promotion)
-        */
-
-    return 0;
+    return gupta_parse_san_move(position, s, m);
 }
 
 static const move_t *parse_move(const char *s)
@@ -1010,7 +1814,7 @@ static int parse_and_make_move(const parsed_command_t *command)
     move = parse_move(command->command);
     if (move)
     {
-        if (!gupta_make_move(move))
+        if (!gupta_make_move(position, move))
         {
             /* Outputting this message in a strict format, as mandated by the CECP
              * specification.
@@ -1019,7 +1823,7 @@ static int parse_and_make_move(const parsed_command_t *command)
             return 0;
         }
 
-        if (gupta_is_game_over(NULL))
+        if (gupta_is_game_over(position, NULL))
             send_result();
 
         return 1;
@@ -1032,7 +1836,7 @@ static int parse_and_make_move(const parsed_command_t *command)
 #ifdef CONFIG_RESIGN
 static void resign()
 {
-    gupta_resign();
+    gupta_resign(position);
 
     /* As it is unclear from the CECP specification whether we should also emit a "result" line
      * after resigning by means of sending a "resign" command, we sidestep the uncertainty by
@@ -1047,7 +1851,7 @@ static void undo()
 {
     user_result.valid = 0;
 
-    gupta_undo_move();
+    gupta_undo_move(position);
 }
 
 int main(void)
@@ -1056,23 +1860,42 @@ int main(void)
 
     log_init();
 
-    /* Non-blocking standard input I/O. */
     if (stdin_init() < 0)
         return 1;
 
     /* Disable standard output buffering. */
     setbuf(stdout, NULL);
 
+    gupta_init();
+    position = gupta_create_position();
+    search = gupta_create_search();
+
+    /* The engine plays without a book if there is none. */
+    (void)gupta_open_book(GUPTA_BOOK_FILE_DEFAULT);
+    /* Likewise for the endgame tablebases. */
+    (void)gupta_open_tablebases(GUPTA_TABLEBASE_PATH_DEFAULT);
+
     /* Put the engine in a defined state. */
     new_game();
 
-    /* Set the search() interrupt-callback used to process data while the engine is calculating. */
-    gupta_set_search_interrupt(interrupt);
+    gupta_set_search_interrupt(search, interrupt);
+    gupta_set_search_info_cb(search, send_thinking_output);
+
+    /* From here on, the standard input stream is read by the input reader thread, which hands the
+     * lines over to process_input(), see stdin_read_line().
+     */
+    if (stdin_start_reader(on_input_line) < 0)
+        r = 1;
+    else
+        r = !loop();
 
-    r = !loop();
+    if (background.is_running)
+        stop_background_search();
 
     log_uninit();
 
+    gupta_destroy_search(search);
+    gupta_destroy_position(position);
     gupta_uninit();
 
     return r;
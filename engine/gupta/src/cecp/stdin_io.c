@@ -33,6 +33,7 @@
 
 #include "stdin_io.h"
 #include "../common.h"
+#include "../enforce.h"
 #include "../uassert.h"
 
 #include <unistd.h>
@@ -46,8 +47,12 @@
 # include <fcntl.h>
 #endif /* defined(_WIN32) */
 
+/* Included after <winsock2.h>, as it includes <windows.h>, which must come after <winsock2.h>. */
+#include "../thread.h"
+
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -57,7 +62,206 @@ static int is_pipe = 0;
 
 static int is_tty = 0;
 
-int stdin_is_data_avail()
+/* A line that was read by the reader thread, waiting to be taken by stdin_read_line(). */
+typedef struct queued_line
+{
+    struct queued_line *next;
+    char line[STDIN_LINE_MAX];
+} queued_line_t;
+
+/* The reader thread blocks on the standard input stream, and queues the lines it reads, see
+ * stdin_start_reader(). Everything in here, except for the thread itself, is protected by the
+ * input lock.
+ */
+static struct
+{
+    mutex_t lock;
+    /* Signaled whenever a line is queued, and when the reader thread stops. */
+    cond_t changed;
+    thread_t thread;
+    stdin_line_cb_t cb;
+    queued_line_t *head,
+                  *tail;
+    /* Once the reader thread has stopped, STDIN_EEOF or STDIN_EIO, and zero before that. */
+    int err;
+} reader;
+
+static void reader_thread(void *arg)
+{
+    queued_line_t *queued;
+    int err;
+
+    (void)arg;
+
+    for (;;)
+    {
+        queued = malloc(sizeof(*queued));
+        if (!queued)
+            enforce(0 && "out of memory");
+
+        if (fgets(queued->line, sizeof(queued->line), stdin) == NULL)
+        {
+            err = feof(stdin) ? STDIN_EEOF : STDIN_EIO;
+            free(queued);
+            break;
+        }
+        queued->next = NULL;
+
+        stdin_lock();
+        if (reader.tail)
+            reader.tail->next = queued;
+        else
+            reader.head = queued;
+        reader.tail = queued;
+        if (reader.cb)
+            reader.cb(queued->line);
+        cond_signal(&reader.changed);
+        stdin_unlock();
+    }
+
+    stdin_lock();
+    reader.err = err;
+    if (reader.cb)
+        reader.cb(NULL);
+    cond_signal(&reader.changed);
+    stdin_unlock();
+}
+
+int stdin_init()
+{
+#ifdef _WIN32
+    hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    if (hStdInput == INVALID_HANDLE_VALUE)
+    {
+        errno = STDIN_EIO;
+        return -1;
+    }
+
+    is_tty = isatty(STDIN_FILENO);
+    if (!is_tty)
+    {
+        if (_setmode(STDIN_FILENO, _O_BINARY) < 0)
+        {
+            errno = STDIN_EIO;
+            return -1;
+        }
+
+        is_pipe = GetNamedPipeInfo(hStdInput, NULL, NULL, NULL, NULL) != 0;
+    }
+#else /* !defined(_WIN32) */
+    is_tty = isatty(STDIN_FILENO);
+    UASSERT(errno != EBADF);
+#endif /* !defined(_WIN32) */
+
+    if (!is_tty)
+    {
+        /* Disable buffering so that fgets() can be used reliably, since if buffering is enabled
+         * and fgets() is used, select() on Unix and PeekNamedPipe() on Win32 may return zero after
+         * one call to fgets() when there is more than one line waiting on the standard input
+         * stream.
+         */
+        setbuf(stdin, NULL);
+    }
+
+    return 0;
+}
+
+/* Starts the reader thread, which from then on is the only reader of the standard input stream.
+ * The thread is never stopped, as it may be blocked reading at any time; it ends with the
+ * process.
+ */
+int stdin_start_reader(stdin_line_cb_t cb)
+{
+    mutex_init(&reader.lock);
+    cond_init(&reader.changed);
+    reader.cb = cb;
+
+    if (!thread_create(&reader.thread, reader_thread, NULL))
+    {
+        cond_destroy(&reader.changed);
+        mutex_destroy(&reader.lock);
+        errno = STDIN_EIO;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Takes the next line queued by the reader thread, see stdin_start_reader(), and blocks until
+ * there is one. Blocking on the queue rather than polling it means that an idle caller uses no
+ * CPU time, and still gets each line as soon as it was read. Returns 1 if a line was copied to
+ * 'buf', or -1 (with 'errno' set to STDIN_EEOF or STDIN_EIO) once all lines were taken and the
+ * reader thread has stopped.
+ */
+int stdin_read_line(char *buf, size_t size)
+{
+    queued_line_t *queued;
+    int r;
+
+    UASSERT(size > 0);
+
+    stdin_lock();
+    while (!reader.head && !reader.err)
+        cond_wait(&reader.changed, &reader.lock);
+    queued = reader.head;
+    if (queued)
+    {
+        reader.head = queued->next;
+        if (!reader.head)
+            reader.tail = NULL;
+        r = 1;
+    }
+    else
+    {
+        errno = reader.err;
+        r = -1;
+    }
+    stdin_unlock();
+
+    if (queued)
+    {
+        strncpy(buf, queued->line, size - 1);
+        buf[size - 1] = '\0';
+        free(queued);
+    }
+
+    return r;
+}
+
+/* Calls 'cb' for every line that is queued, and then with NULL if the reader thread has stopped,
+ * just as the reader thread calls the line callback (see stdin_line_cb_t). The caller must hold
+ * the input lock.
+ */
+void stdin_scan_queued_lines(stdin_line_cb_t cb)
+{
+    const queued_line_t *queued;
+
+    for (queued = reader.head; queued; queued = queued->next)
+        cb(queued->line);
+
+    if (reader.err)
+        cb(NULL);
+}
+
+/* The input lock serializes the reader thread, and thus the line callback that was passed to
+ * stdin_start_reader(), with the caller.
+ */
+void stdin_lock(void)
+{
+    mutex_lock(&reader.lock);
+}
+
+void stdin_unlock(void)
+{
+    mutex_unlock(&reader.lock);
+}
+
+#ifdef STDIN_IO_TEST
+/* Returns whether the standard input stream has data waiting to be read, without blocking, or -1
+ * (with 'errno' set to STDIN_EEOF or STDIN_EIO) on failure. Only the test below still polls the
+ * standard input stream; the engine reads it with the reader thread instead.
+ */
+static int stdin_is_data_avail(void)
 {
 #ifdef _WIN32
     DWORD num;
@@ -129,46 +333,6 @@ int stdin_is_data_avail()
 #endif /* !defined(_WIN32) */
 }
 
-int stdin_init()
-{
-#ifdef _WIN32
-    hStdInput = GetStdHandle(STD_INPUT_HANDLE);
-    if (hStdInput == INVALID_HANDLE_VALUE)
-    {
-        errno = STDIN_EIO;
-        return -1;
-    }
-
-    is_tty = isatty(STDIN_FILENO);
-    if (!is_tty)
-    {
-        if (_setmode(STDIN_FILENO, _O_BINARY) < 0)
-        {
-            errno = STDIN_EIO;
-            return -1;
-        }
-
-        is_pipe = GetNamedPipeInfo(hStdInput, NULL, NULL, NULL, NULL) != 0;
-    }
-#else /* !defined(_WIN32) */
-    is_tty = isatty(STDIN_FILENO);
-    UASSERT(errno != EBADF);
-#endif /* !defined(_WIN32) */
-
-    if (!is_tty)
-    {
-        /* Disable buffering so that fgets() can be used reliably, since if buffering is enabled
-         * and fgets() is used, select() on Unix and PeekNamedPipe() on Win32 may return zero after
-         * one call to fgets() when there is more than one line waiting on the standard input
-         * stream.
-         */
-        setbuf(stdin, NULL);
-    }
-
-    return 0;
-}
-
-#ifdef STDIN_IO_TEST
 static void hexdump(const void *s)
 {
     const char *p = (const char *)s;
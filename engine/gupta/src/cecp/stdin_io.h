@@ -19,7 +19,22 @@
 #define STDIN_EEOF 1 /* End-of-file reached. */
 #define STDIN_EIO  2 /* I/O error. */
 
-int stdin_is_data_avail(void);
+/* The maximum size of a line read by stdin_read_line(), including the null-terminator. Longer
+ * lines are split.
+ */
+#define STDIN_LINE_MAX 1024
+
+/* Called by the reader thread for every line it reads, right after the line was queued, or with
+ * NULL once the reader thread stops because of the end of the input or an I/O error. It is called
+ * with the input lock held, see stdin_lock().
+ */
+typedef void (*stdin_line_cb_t)(const char *line);
+
 int stdin_init(void);
+int stdin_start_reader(stdin_line_cb_t cb);
+int stdin_read_line(char *buf, size_t size);
+void stdin_scan_queued_lines(stdin_line_cb_t cb);
+void stdin_lock(void);
+void stdin_unlock(void);
 
 #endif /* !defined(STDIN_IO_H) */
@@ -45,6 +45,33 @@
 # define ATTRIBUTE_FORMAT(i,j,k) __attribute__((__format__(i,j,k))) ATTRIBUTE_NONNULL(j)
 # define ATTRIBUTE_FORMAT_PRINTF __printf__
 # define ATTRIBUTE_FORMAT_SCANF __scanf__
+
+/* Gives each thread its own instance of a static variable. */
+# define THREAD_LOCAL __thread
+
+/* Loads and stores of variables that are shared between threads. They are atomic (a value is
+ * never seen half-written), but they don't order any other memory accesses.
+ */
+# if GCC_VERSION >= 4007
+#  define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#  define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+# else /* GCC_VERSION < 4007 */
+#  define ATOMIC_LOAD(p) (*(volatile __typeof__(*(p)) *)(p))
+#  define ATOMIC_STORE(p, v) ((void)(*(volatile __typeof__(*(p)) *)(p) = (v)))
+# endif /* GCC_VERSION < 4007 */
+
+/* Like ATOMIC_LOAD() and ATOMIC_STORE(), but everything written by a thread before it stores a
+ * value with ATOMIC_STORE_RELEASE() is seen by a thread that loads that value with
+ * ATOMIC_LOAD_ACQUIRE().
+ */
+# if GCC_VERSION >= 4007
+#  define ATOMIC_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#  define ATOMIC_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+# else /* GCC_VERSION < 4007 */
+#  define ATOMIC_LOAD_ACQUIRE(p)                                                                  \
+    __extension__ ({ __typeof__(*(p)) v_ = ATOMIC_LOAD(p); __sync_synchronize(); v_; })
+#  define ATOMIC_STORE_RELEASE(p, v) (__sync_synchronize(), ATOMIC_STORE((p), (v)))
+# endif /* GCC_VERSION < 4007 */
 #endif /* defined(__GNUC__) */
 
 #endif /* !defined(COMPILER_SPECIFIC_H) */
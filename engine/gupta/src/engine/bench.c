@@ -0,0 +1,98 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#include "bench_public.h"
+#include "board_public.h"
+#include "common.h"
+#include "move_public.h"
+#include "rules_public.h"
+#include "search_public.h"
+#include "ttable_public.h"
+#include "timer.h"
+#include "uassert.h"
+
+#include <stdio.h>
+
+/* A mix of opening, middle-game and end-game positions. */
+static const char *bench_positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2r3k1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/4R1K1 b - - 0 20",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/5pk1/6p1/p7/P3K3/6P1/5P2/8 w - - 0 40",
+    "6k1/5p2/6p1/8/7P/8/5PK1/3R4 w - - 0 50"
+};
+
+void gupta_bench(const gupta_search_t *caller, size_t depth)
+{
+    gupta_position_t *pos = gupta_create_position();
+    /* The bench has a search of its own, so that the settings (such as the clock) and the move
+     * ordering heuristics of the caller's search are left alone.
+     */
+    gupta_search_t *s = gupta_create_search();
+    size_t i;
+    u64 total_nodes = 0,
+        total_ms = 0,
+        signature = 0xCBF29CE484222325ULL;
+
+    if (depth == 0)
+        depth = GUPTA_BENCH_DEPTH_DEFAULT;
+
+    gupta_set_search_threads(s, gupta_get_search_threads(caller));
+    gupta_set_search_depth(s, depth);
+    gupta_set_search_time(s, GUPTA_SEARCH_TIME_INFINITE);
+    gupta_set_search_book(s, 0);
+    gupta_set_search_tablebases(s, 0);
+
+    for (i = 0; i < ARRAY_SIZE(bench_positions); i++)
+    {
+        u64 nodes,
+            ms;
+
+        /* Start every search from the same state, regardless of what was searched before. */
+        gupta_new_game(pos);
+        gupta_clear_hash();
+        gupta_clear_search(s);
+        if (!gupta_set_board_from_fen(pos, bench_positions[i]))
+        {
+            UASSERT(0 && "invalid bench position");
+            continue;
+        }
+
+        ms = timer_get_ms();
+        gupta_find_move(s, pos);
+        ms = timer_get_ms() - ms;
+
+        nodes = gupta_get_search_nodes(s);
+        total_nodes += nodes;
+        total_ms += ms;
+
+        /* FNV-1a style hash of the node counts. */
+        signature = (signature ^ nodes) * 0x100000001B3ULL;
+
+        printf("%u. %s\n   best move %s, nodes %llu, time %llu ms, nps %llu\n",
+               (unsigned int)(i + 1), bench_positions[i],
+               gupta_move_to_can(gupta_get_best_move(s)), nodes, ms,
+               ms ? nodes * 1000 / ms : 0);
+    }
+
+    printf("Total: depth %u, nodes %llu, time %llu ms, nps %llu\n", (unsigned int)depth,
+           total_nodes, total_ms, total_ms ? total_nodes * 1000 / total_ms : 0);
+    printf("Signature: %016llx\n", signature);
+
+    gupta_destroy_search(s);
+    gupta_destroy_position(pos);
+}
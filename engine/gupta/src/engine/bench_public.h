@@ -0,0 +1,35 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef BENCH_PUBLIC_H
+#define BENCH_PUBLIC_H
+
+#include "search_public.h"
+
+#include <stddef.h>
+
+#define GUPTA_BENCH_DEPTH_DEFAULT 9
+
+/* Searches each position of a built-in set to a fixed depth ('depth' plies, or
+ * GUPTA_BENCH_DEPTH_DEFAULT if 'depth' is 0), with as many threads as search 'caller' uses. The
+ * bench uses a search of its own, so 'caller' is left as it is. Each search starts with an empty
+ * transposition table and cleared move ordering heuristics. The nodes, time and nodes per second
+ * are shown for each position and in total, along with a signature of the node counts. As the
+ * searches aren't limited by time, the signature only changes when the behavior of the search
+ * changes, not when only its speed does. That only holds for a single thread though: with more
+ * threads (see gupta_set_search_threads()), the node counts vary from run to run.
+ */
+void gupta_bench(const gupta_search_t *caller, size_t depth);
+
+#endif /* !defined(BENCH_PUBLIC_H) */
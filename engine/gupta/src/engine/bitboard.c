@@ -0,0 +1,282 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#include "bitboard.h"
+#include "common.h"
+#include "piece_public.h"
+#include "uassert.h"
+
+#include <stddef.h>
+
+u64 g_knight_attacks[64];
+u64 g_king_attacks[64];
+u64 g_pawn_attacks[2][64];
+magic_t g_bishop_magics[64];
+magic_t g_rook_magics[64];
+u64 g_between[64][64];
+u64 g_line[64][64];
+
+/* The attack tables of all squares, one after the other. The table of a square has an entry for
+ * every index the magic multiplication can produce, that is, '1 << (64 - shift)' entries.
+ */
+static u64 bishop_attack_table[0x1480];
+static u64 rook_attack_table[0x19000];
+
+/* Steps are given as {file delta, rank delta}. */
+static const int knight_steps[][2] = {
+    {+1, +2}, {+2, +1}, {+2, -1}, {+1, -2}, {-1, -2}, {-2, -1}, {-2, +1}, {-1, +2}
+};
+static const int king_steps[][2] = {
+    {+1, 0}, {+1, +1}, {0, +1}, {-1, +1}, {-1, 0}, {-1, -1}, {0, -1}, {+1, -1}
+};
+static const int pawn_steps[][2][2] = {
+    {{-1, +1}, {+1, +1}}, /* White pawns. */
+    {{-1, -1}, {+1, -1}}  /* Black pawns. */
+};
+static const int bishop_directions[][2] = {{+1, +1}, {+1, -1}, {-1, -1}, {-1, +1}};
+static const int rook_directions[][2]   = {{+1, 0}, {0, -1}, {-1, 0}, {0, +1}};
+
+static int is_on_board(int file, int rank)
+{
+    return (file >= 0) && (file < 8) && (rank >= 0) && (rank < 8);
+}
+
+/* Returns the squares that can be reached from 'sq' by taking a single step. */
+static u64 step_attacks(int sq, const int steps[][2], size_t num_steps)
+{
+    u64 attacks = 0;
+    size_t i;
+
+    for (i = 0; i < num_steps; i++)
+    {
+        int file = (sq & 7) + steps[i][0],
+            rank = (sq >> 3) + steps[i][1];
+
+        if (is_on_board(file, rank))
+            attacks |= BB_SQUARE(rank * 8 + file);
+    }
+
+    return attacks;
+}
+
+/* Returns the squares a slider on 'sq' attacks, by walking in each direction until an occupied
+ * square is hit. This is slow, and is only used to fill the attack tables.
+ */
+static u64 slider_attacks(int sq, u64 occupied, const int directions[4][2])
+{
+    u64 attacks = 0;
+    size_t i;
+
+    for (i = 0; i < 4; i++)
+    {
+        int file = (sq & 7) + directions[i][0],
+            rank = (sq >> 3) + directions[i][1];
+
+        for (; is_on_board(file, rank); file += directions[i][0], rank += directions[i][1])
+        {
+            u64 bb = BB_SQUARE(rank * 8 + file);
+
+            attacks |= bb;
+            if (occupied & bb)
+                break;
+        }
+    }
+
+    return attacks;
+}
+
+/* Returns the squares that can block a slider on 'sq'. The last square in each direction can't
+ * block anything, so it doesn't have to be part of the magic index.
+ */
+static u64 slider_mask(int sq, const int directions[4][2])
+{
+    u64 mask = 0;
+    size_t i;
+
+    for (i = 0; i < 4; i++)
+    {
+        int file = (sq & 7) + directions[i][0],
+            rank = (sq >> 3) + directions[i][1];
+
+        for (; is_on_board(file + directions[i][0], rank + directions[i][1]);
+             file += directions[i][0], rank += directions[i][1])
+        {
+            mask |= BB_SQUARE(rank * 8 + file);
+        }
+    }
+
+    return mask;
+}
+
+/* The magic numbers were found by trial and error, by trying random numbers with few bits set
+ * until all subsets of the mask of a square mapped to an index without a collision that would
+ * result in different attacks.
+ */
+static const u64 bishop_magic_numbers[64] = {
+    0x0020428400408200ULL, 0x2008010104210004ULL, 0x02D0009200480190ULL,
+    0x0018158B00010100ULL, 0x02C4042132048008ULL, 0x020082202000C221ULL,
+    0x4000421050080009ULL, 0x0210140202022020ULL, 0x00C0101410042248ULL,
+    0x0405204800D48080ULL, 0x3800C89200420002ULL, 0x180844124A020440ULL,
+    0x04403410A8002221ULL, 0x4040209004200400ULL, 0x084004020202A204ULL,
+    0x3010002104022000ULL, 0x00200240A9110900ULL, 0x2302800404080210ULL,
+    0x0204188800240010ULL, 0x8048000C01401200ULL, 0x120C001A11040900ULL,
+    0x0000401200500440ULL, 0x00004040840420A0ULL, 0x0020930822880804ULL,
+    0x4044401090900161ULL, 0x0034100015210804ULL, 0x8004100009010120ULL,
+    0x48C8080000820500ULL, 0x0080848004002000ULL, 0x0801004012005044ULL,
+    0x000080902C040400ULL, 0x0004009005004100ULL, 0x0B103010048A0200ULL,
+    0x8004100203181A00ULL, 0x0800140200100080ULL, 0x8401010800910040ULL,
+    0x0840010011290040ULL, 0x40100214202E1000ULL, 0x0842040040010840ULL,
+    0x0028010040010860ULL, 0x00080202A2051000ULL, 0x4200841008084204ULL,
+    0x0021120110000D02ULL, 0x48C1004208000084ULL, 0x0010088100414400ULL,
+    0x0021101000420580ULL, 0x0010040558401410ULL, 0x200C0C82A1050205ULL,
+    0x0011108820088000ULL, 0x0001011910120402ULL, 0x1580008608091248ULL,
+    0x8010018020880C02ULL, 0x20A1101032088480ULL, 0x0080100408082800ULL,
+    0x28100401140401C0ULL, 0x8002102200930012ULL, 0x4001040082080200ULL,
+    0x082200A498081808ULL, 0x000508610080D003ULL, 0x0052020044842402ULL,
+    0x4800A00140C84840ULL, 0x5000000848080820ULL, 0x0101086004240040ULL,
+    0x0028280808005014ULL
+};
+static const u64 rook_magic_numbers[64] = {
+    0x008000908064C000ULL, 0x0040200040001000ULL, 0x0180100080A0010AULL,
+    0x8880041000800800ULL, 0x1200100201200804ULL, 0x0200020004011008ULL,
+    0x2180010000800600ULL, 0x0200005088210204ULL, 0x0400800040008021ULL,
+    0x0400400020005000ULL, 0x8240801000200080ULL, 0x8611001004200900ULL,
+    0x008180800C001800ULL, 0x0100800200800400ULL, 0x0A02000102000408ULL,
+    0x8020802300104280ULL, 0x0080004000402000ULL, 0xE010104000402000ULL,
+    0x0800808010002000ULL, 0xA280210008100100ULL, 0x0001818014000800ULL,
+    0xA002010100080400ULL, 0x0080240001020870ULL, 0x0001020004048845ULL,
+    0x0081826280004004ULL, 0x2020810900284000ULL, 0x0200100080802000ULL,
+    0x0200080080100080ULL, 0x8083080100100500ULL, 0x4406000901000400ULL,
+    0x0005020080800100ULL, 0x0090204200008114ULL, 0x0010400094800420ULL,
+    0x0900804000802002ULL, 0x0201001841002000ULL, 0x4100080080801000ULL,
+    0x4540040080800800ULL, 0x0002001004040020ULL, 0x0281195814001002ULL,
+    0x1240800040800100ULL, 0x0880042000524004ULL, 0x02C080410206002CULL,
+    0x0801200241050010ULL, 0x8400080010008080ULL, 0x0008000500090010ULL,
+    0x0082009084020008ULL, 0x4012000108020004ULL, 0x9000104D08860004ULL,
+    0x2004204114800100ULL, 0x0148802112400300ULL, 0x0202842000100880ULL,
+    0x001B080080900080ULL, 0x001A002008100600ULL, 0x0004008004020080ULL,
+    0x5181000600040300ULL, 0x0000044401128A00ULL, 0x8044110480002441ULL,
+    0x2008110084402202ULL, 0x90806005090010C1ULL, 0x000420310A004A42ULL,
+    0x0023001004020801ULL, 0x0882001008040102ULL, 0x000230088118020CULL,
+    0x0000019025040042ULL
+};
+
+/* Fills in the magics for every square, and the attack tables they index into. Returns one past
+ * the last attack table entry used.
+ */
+static u64 *init_magics(magic_t *magics, const u64 *magic_numbers, u64 *table,
+                        const int directions[4][2])
+{
+    int sq;
+
+    for (sq = 0; sq < 64; sq++)
+    {
+        magic_t *m = &magics[sq];
+        u64 subset = 0;
+
+        m->mask = slider_mask(sq, directions);
+        m->magic = magic_numbers[sq];
+        m->shift = 64 - BB_POPCOUNT(m->mask);
+        m->attacks = table;
+
+        /* Enumerate all subsets of the mask. A slider always attacks at least one square, so an
+         * empty entry hasn't been used yet, and different subsets may only share an entry if they
+         * result in the same attacks.
+         */
+        do
+        {
+            u64 attacks = slider_attacks(sq, subset, directions);
+            size_t index = (subset * m->magic) >> m->shift;
+
+            UASSERT(!table[index] || (table[index] == attacks));
+            table[index] = attacks;
+
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        table += (size_t)1 << (64 - m->shift);
+    }
+
+    return table;
+}
+
+void init_bitboards()
+{
+    int sq,
+        other;
+    const u64 *end;
+
+    for (sq = 0; sq < 64; sq++)
+    {
+        g_knight_attacks[sq] = step_attacks(sq, knight_steps, ARRAY_SIZE(knight_steps));
+        g_king_attacks[sq] = step_attacks(sq, king_steps, ARRAY_SIZE(king_steps));
+        g_pawn_attacks[0][sq] = step_attacks(sq, pawn_steps[0], ARRAY_SIZE(pawn_steps[0]));
+        g_pawn_attacks[1][sq] = step_attacks(sq, pawn_steps[1], ARRAY_SIZE(pawn_steps[1]));
+    }
+
+    end = init_magics(g_bishop_magics, bishop_magic_numbers, bishop_attack_table,
+                      bishop_directions);
+    UASSERT(end == bishop_attack_table + ARRAY_SIZE(bishop_attack_table));
+    end = init_magics(g_rook_magics, rook_magic_numbers, rook_attack_table, rook_directions);
+    UASSERT(end == rook_attack_table + ARRAY_SIZE(rook_attack_table));
+    (void)end;
+
+    /* Two squares share a line if a slider on one of them attacks the other on an empty board. The
+     * squares in between are those that the sliders on both squares attack when the other square
+     * is occupied.
+     */
+    for (sq = 0; sq < 64; sq++)
+    {
+        for (other = 0; other < 64; other++)
+        {
+            if (BISHOP_ATTACKS(sq, 0) & BB_SQUARE(other))
+            {
+                g_line[sq][other] = (BISHOP_ATTACKS(sq, 0) & BISHOP_ATTACKS(other, 0)) |
+                                    BB_SQUARE(sq) | BB_SQUARE(other);
+                g_between[sq][other] = BISHOP_ATTACKS(sq, BB_SQUARE(other)) &
+                                       BISHOP_ATTACKS(other, BB_SQUARE(sq));
+            }
+            else if (ROOK_ATTACKS(sq, 0) & BB_SQUARE(other))
+            {
+                g_line[sq][other] = (ROOK_ATTACKS(sq, 0) & ROOK_ATTACKS(other, 0)) |
+                                    BB_SQUARE(sq) | BB_SQUARE(other);
+                g_between[sq][other] = ROOK_ATTACKS(sq, BB_SQUARE(other)) &
+                                       ROOK_ATTACKS(other, BB_SQUARE(sq));
+            }
+        }
+    }
+}
+
+/* Returns the squares attacked by a piece of the given type (any type other than a pawn) on 'sq',
+ * where the pieces on the squares in 'occupied' block the sliding pieces.
+ */
+u64 piece_attacks(int type, int sq, u64 occupied)
+{
+    switch (type)
+    {
+    case KNIGHT:
+        return g_knight_attacks[sq];
+    case KING:
+        return g_king_attacks[sq];
+    case BISHOP:
+        return BISHOP_ATTACKS(sq, occupied);
+    case ROOK:
+        return ROOK_ATTACKS(sq, occupied);
+    case QUEEN:
+        return QUEEN_ATTACKS(sq, occupied);
+    default:
+        UASSERT(0);
+        return 0;
+    }
+}
@@ -0,0 +1,81 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "types.h"
+
+/* A bitboard is a set of squares, stored in a 64-bit integer. Bit 0 represents square a1, bit 7
+ * square h1, bit 8 square a2, and so on, up to bit 63, which represents square h8.
+ *
+ * Moves and the board itself use 0x88 locations (see 'board.h'). SQ64() converts a valid 0x88
+ * location to a bitboard square index, SQ88() converts it back.
+ */
+#define SQ64(location) (((location) + ((location) & 0x07)) >> 1)
+#define SQ88(sq)       ((sq) + ((sq) & ~0x07))
+
+#define BB_SQUARE(sq) (1ULL << (sq))
+
+#define BB_FILE_A 0x0101010101010101ULL
+#define BB_FILE_H 0x8080808080808080ULL
+#define BB_RANK_1 0x00000000000000FFULL
+#define BB_RANK_3 0x0000000000FF0000ULL
+#define BB_RANK_6 0x0000FF0000000000ULL
+#define BB_RANK_8 0xFF00000000000000ULL
+#define BB_LIGHT_SQUARES 0x55AA55AA55AA55AAULL
+
+#define BB_POPCOUNT(bb) __builtin_popcountll(bb)
+/* Returns the index of the least significant square in the set. The set must not be empty. */
+#define BB_LSB(bb) __builtin_ctzll(bb)
+/* Removes the least significant square from the set. */
+#define BB_CLEAR_LSB(bb) ((bb) &= (bb) - 1)
+/* Whether the set holds more than one square. */
+#define BB_HAS_MANY(bb) (((bb) & ((bb) - 1)) != 0)
+
+/* The attacks of a sliding piece are looked up with 'magic' multiplication. The occupied squares
+ * that can block the slider (the relevant squares in 'mask') are multiplied by the magic number,
+ * which maps every possible subset of them to a unique index in the top 'shift' bits. Different
+ * subsets that result in the same attacks may share an index.
+ */
+typedef struct
+{
+    u64 mask;
+    u64 magic;
+    const u64 *attacks;
+    int shift;
+} magic_t;
+
+extern u64 g_knight_attacks[64];
+extern u64 g_king_attacks[64];
+/* Indexed by the side of the pawn. */
+extern u64 g_pawn_attacks[2][64];
+extern magic_t g_bishop_magics[64];
+extern magic_t g_rook_magics[64];
+/* For two squares on a common rank, file or diagonal, 'g_between' holds the squares in between
+ * them, and 'g_line' the whole rank, file or diagonal. Both are empty for other pairs of squares.
+ */
+extern u64 g_between[64][64];
+extern u64 g_line[64][64];
+
+#define MAGIC_ATTACKS(m, occupied) ((m).attacks[(((occupied) & (m).mask) * (m).magic) >> (m).shift])
+#define BISHOP_ATTACKS(sq, occupied) MAGIC_ATTACKS(g_bishop_magics[(sq)], (occupied))
+#define ROOK_ATTACKS(sq, occupied)   MAGIC_ATTACKS(g_rook_magics[(sq)], (occupied))
+#define QUEEN_ATTACKS(sq, occupied)  (BISHOP_ATTACKS((sq), (occupied)) |                          \
+                                      ROOK_ATTACKS((sq), (occupied)))
+
+void init_bitboards(void);
+u64 piece_attacks(int type, int sq, u64 occupied);
+
+#endif /* !defined(BITBOARD_H) */
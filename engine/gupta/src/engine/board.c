@@ -13,24 +13,50 @@
 
 #include "board.h"
 #include "common.h"
+#include "enforce.h"
+#include "eval.h"
 #include "fen.h"
+#include "material.h"
 #include "rules.h"
 #include "uassert.h"
-#include "eval.h" /* TODO: remove later */
+#include "zobrist.h"
 #include "move.h" /* TODO: remove later */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h> /* TODO: remove later */
 
-piece_t *g_board[128];
+static void clear_board(s8 *board)
+{
+    u8 sq;
+
+    for (sq = 0x00; sq <= 0x77; sq += (sq & 7) == 7 ? +0x09 : +0x01)
+        board[sq] = NOPIECE;
+}
 
-static void clear_board(piece_t **board)
+/* Sets up the bitboards, and the material key and evaluation sums that derive from them, from
+ * the pieces on the board.
+ */
+static void compute_bitboards(gupta_position_t *pos)
 {
     u8 sq;
 
+    memset(pos->bitboards, 0, sizeof(pos->bitboards));
+
     for (sq = 0x00; sq <= 0x77; sq += (sq & 7) == 7 ? +0x09 : +0x01)
-        board[sq] = NULL;
+    {
+        s8 piece = pos->board[sq];
+
+        if (piece != NOPIECE)
+        {
+            pos->bitboards[PIECE_SIDE(piece)][PIECE_TYPE(piece)] |= BB_SQUARE(SQ64(sq));
+            pos->bitboards[PIECE_SIDE(piece)][NOPIECE] |= BB_SQUARE(SQ64(sq));
+        }
+    }
+
+    pos->material_key = compute_material_key(pos);
+    compute_eval_sums(pos);
 }
 
 static u8 coord_to_0x88(int x, int y)
@@ -85,23 +111,14 @@ static s8 fen_piece_to_gupta_piece(char fen_piece_type)
     return side == WHITE ? t : -t;
 }
 
-static int set_game_from_fen(const fen_game_t *game)
+static int set_game_from_fen(gupta_position_t *pos, const fen_game_t *game)
 {
-    int side,
-        x,
+    int x,
         y;
-    size_t i;
-    s8 type;
-
-    clear_pieces();
-    assert((g_piece_ranges[0].begin == 0) &&
-           (g_piece_ranges[0].end == 0) &&
-           (g_piece_ranges[1].begin == 64) &&
-           (g_piece_ranges[1].end == 64));
 
-    clear_board(g_board);
+    clear_board(pos->board);
 
-    /* Initialize the pieces and the board. */
+    /* Initialize the board. */
     UASSERT(ARRAY_SIZE(game->board) == 8);
     UASSERT(ARRAY_SIZE(game->board[0]) == 8);
     for (y = 0; y < 8; y++)
@@ -111,59 +128,19 @@ static int set_game_from_fen(const fen_game_t *game)
             char fen_piece_type = game->board[y][x];
             if (fen_piece_type != FEN_EMPTY_SQUARE)
             {
-                piece_t *piece = NULL;
-
-                side = fen_piece_type < 0 ? BLACK : WHITE;
-
-                type = fen_piece_to_gupta_piece(game->board[y][x]);
-                if (type == NOPIECE)
+                s8 piece = fen_piece_to_gupta_piece(fen_piece_type);
+                if (piece == NOPIECE)
                 {
                     assert(0);
                     return 0;
                 }
 
-                assert(g_piece_ranges[side].end < ARRAY_SIZE(g_pieces));
-                piece = &g_pieces[g_piece_ranges[side].end];
-
-                piece->_type = type;
-                piece->location = coord_to_0x88(x, y);
-                piece->is_captured = 0;
-
-                g_piece_ranges[side].end++;
-
-                g_board[piece->location] = piece;
+                pos->board[coord_to_0x88(x, y)] = piece;
             }
         }
     }
-    /* Put the kings at predefined positions in the array, for faster lookup (other blocks of code
-     * hardcode the array positions of the kings).
-     */
-    for (side = 0; side < 2; side++)
-    {
-        for (i = g_piece_ranges[side].begin; i < g_piece_ranges[side].end; i++)
-        {
-            const piece_t p = g_pieces[i];
-
-            type = PIECE_TYPE(p);
 
-            if (type == KING)
-            {
-                /* We're now going to swap the king with the other piece that sits at the location
-                 * in the array that we want the king at.
-                 */
-
-                /* First, overwrite the king piece with the other piece. */
-                g_pieces[i] = g_pieces[g_piece_ranges[side].begin];
-                g_board[g_pieces[i].location] = &g_pieces[i];
-
-                /* And then, overwrite the other piece with the king piece. */
-                g_pieces[g_piece_ranges[side].begin] = p;
-                g_board[g_pieces[g_piece_ranges[side].begin].location] = &g_pieces[g_piece_ranges[side].begin];
-
-                break;
-            }
-        }
-    }
+    compute_bitboards(pos);
 
     if (game->en_passant.have_square)
     {
@@ -195,21 +172,21 @@ static int set_game_from_fen(const fen_game_t *game)
             return 0;
         }
 
-        g_en_passant = en_passant;
+        pos->en_passant = en_passant;
     }
 
     /* FEN strings don't specify whether the king is available for castling, and so we never set
      * WHITE_KING_IS_NOT_AVAILABLE or BLACK_KING_IS_NOT_AVAILABLE, but this doesn't matter.
      */
-    g_castling = 0;
+    pos->castling = 0;
     if (!game->castling[FEN_WHITE][0])
-        g_castling |= WHITE_KINGS_ROOK_IS_NOT_AVAILABLE;
+        pos->castling |= WHITE_KINGS_ROOK_IS_NOT_AVAILABLE;
     if (!game->castling[FEN_WHITE][1])
-        g_castling |= WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE;
+        pos->castling |= WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE;
     if (!game->castling[FEN_BLACK][0])
-        g_castling |= BLACK_KINGS_ROOK_IS_NOT_AVAILABLE;
+        pos->castling |= BLACK_KINGS_ROOK_IS_NOT_AVAILABLE;
     if (!game->castling[FEN_BLACK][1])
-        g_castling |= BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE;
+        pos->castling |= BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE;
 
     if (game->castling[FEN_WHITE][0] || game->castling[FEN_WHITE][1])
     {
@@ -220,13 +197,13 @@ static int set_game_from_fen(const fen_game_t *game)
         if (game->castling[FEN_WHITE][0])
         {
             /* The white kingside rook should be available for castling. */
-            if (game->board[7][0] != FEN_ROOK)
+            if (game->board[7][7] != FEN_ROOK)
                 return 0;
         }
         if (game->castling[FEN_WHITE][1])
         {
             /* The white queenside rook should be available for castling. */
-            if (game->board[7][7] != FEN_ROOK)
+            if (game->board[7][0] != FEN_ROOK)
                 return 0;
         }
     }
@@ -239,28 +216,101 @@ static int set_game_from_fen(const fen_game_t *game)
         if (game->castling[FEN_BLACK][0])
         {
             /* The black kingside rook should be available for castling. */
-            if (game->board[0][0] != -FEN_ROOK)
+            if (game->board[0][7] != -FEN_ROOK)
                 return 0;
         }
         if (game->castling[FEN_BLACK][1])
         {
             /* The black queenside rook should be available for castling. */
-            if (game->board[0][7] != -FEN_ROOK)
+            if (game->board[0][0] != -FEN_ROOK)
                 return 0;
         }
     }
 
     assert((game->turn == FEN_WHITE) || (game->turn == FEN_BLACK));
-    set_turn(game->turn == FEN_WHITE ? WHITE : BLACK);
+    set_turn(pos, game->turn == FEN_WHITE ? WHITE : BLACK);
 
-    /* TODO XXX
-     * If at some point we keep track of the number of halfmoves and fullmoves, then we should use that data
-     * from the FEN string as well.
-     */
+    /* The fullmove number doesn't matter to the engine, so only the halfmove clock is used. */
+    pos->halfmove_clock = game->halfmoves;
+
+    pos->hash_key = compute_hash_key(pos);
 
     return 1;
 }
 
+/* Creates a position, set up for a new game. */
+gupta_position_t *gupta_create_position()
+{
+    gupta_position_t *pos = calloc(1, sizeof(*pos));
+
+    if (!pos)
+        enforce(0 && "out of memory");
+
+    gupta_new_game(pos);
+
+    return pos;
+}
+
+void gupta_destroy_position(gupta_position_t *pos)
+{
+    free(pos->history_stack);
+    free(pos);
+}
+
+/* Makes position 'dst' a copy of position 'src', including the moves that led to it, such that
+ * they can be undone in 'dst' as well.
+ */
+void copy_position(gupta_position_t *dst, const gupta_position_t *src)
+{
+    history_t *history_stack = dst->history_stack;
+    size_t history_stack_num_elements = dst->history_stack_num_elements;
+
+    if (history_stack_num_elements < src->history_stack_num_elements)
+    {
+        history_stack_num_elements = src->history_stack_num_elements;
+        history_stack = realloc(history_stack, history_stack_num_elements * sizeof(*history_stack));
+        if (!history_stack)
+        {
+            free(dst->history_stack);
+            enforce(0 && "out of memory");
+        }
+    }
+
+    *dst = *src;
+
+    dst->history_stack = history_stack;
+    dst->history_stack_num_elements = history_stack_num_elements;
+    if (src->history_idx)
+        memcpy(dst->history_stack, src->history_stack, src->history_idx * sizeof(*history_stack));
+}
+
+/* Sets up position 'pos' with just the pieces 'pieces' on the 0x88 locations 'locations', and
+ * 'side' to move, without castling or En Passant opportunities, and without any moves to undo.
+ * Unlike gupta_set_board_from_fen(), this doesn't check whether the position is valid, as it is
+ * meant for setting up many positions quickly, such as for generating the endgame tablebases.
+ */
+void set_board_from_pieces(gupta_position_t *pos, const s8 *pieces, const u8 *locations,
+                           size_t num_pieces, int side)
+{
+    size_t i;
+
+    clear_board(pos->board);
+    for (i = 0; i < num_pieces; i++)
+        pos->board[locations[i]] = pieces[i];
+
+    compute_bitboards(pos);
+
+    pos->result = GUPTA_RESULT_NONE;
+    set_turn(pos, side);
+    pos->history_idx = 0;
+    pos->castling = WHITE_KING_IS_NOT_AVAILABLE | BLACK_KING_IS_NOT_AVAILABLE;
+    pos->castle_booleans[WHITE] = 0;
+    pos->castle_booleans[BLACK] = 0;
+    pos->en_passant = 0x88;
+    pos->halfmove_clock = 0;
+    pos->hash_key = compute_hash_key(pos);
+}
+
 char *gupta_fen_buffer(void)
 {
     static char fen[FEN_BUFSIZE_MAX];
@@ -272,7 +322,7 @@ size_t gupta_fen_buffer_size(void)
     return FEN_BUFSIZE_MAX;
 }
 
-int gupta_set_board_from_fen(const char *fen)
+int gupta_set_board_from_fen(gupta_position_t *pos, const char *fen)
 {
     int result = 0;
     fen_game_t game;
@@ -301,15 +351,19 @@ int gupta_set_board_from_fen(const char *fen)
     if ((kings[WHITE] != 1) || (kings[BLACK] != 1))
         goto done;
 
-    if (!set_game_from_fen(&game))
-    {
-        contamination = 1;
+    contamination = 1;
+    if (!set_game_from_fen(pos, &game))
+        goto done;
+
+    /* The side that just moved can't be left in check. Besides making no sense, the move generator
+     * relies on this, as it only generates legal moves, and never a king capture.
+     */
+    if (is_king_in_check(pos, pos->oside))
         goto done;
-    }
 
     /* Don't allow both sides to be in checkmate, such positions make no sense. */
-    if ((!can_make_any_move(WHITE) && is_king_in_check(WHITE)) &&
-        (!can_make_any_move(BLACK) && is_king_in_check(BLACK)))
+    if ((!can_make_any_move(pos, WHITE) && is_king_in_check(pos, WHITE)) &&
+        (!can_make_any_move(pos, BLACK) && is_king_in_check(pos, BLACK)))
     {
         goto done;
     }
@@ -318,8 +372,8 @@ int gupta_set_board_from_fen(const char *fen)
      *     Knnnknnn/pnpnpnpn/npnpnpnp/pnpnpnpn/npnpnpnp/pnpnpnpn/npnpnpnp/nnnnnnnn w - - 0 1
      * In the position denoted by this FEN string, both sides would be in stalemate.
      */
-    if ((!can_make_any_move(WHITE) && !is_king_in_check(WHITE)) &&
-        (!can_make_any_move(BLACK) && !is_king_in_check(BLACK)))
+    if ((!can_make_any_move(pos, WHITE) && !is_king_in_check(pos, WHITE)) &&
+        (!can_make_any_move(pos, BLACK) && !is_king_in_check(pos, BLACK)))
     {
         goto done;
     }
@@ -335,12 +389,12 @@ done:
          * determine the validity of the FEN game, and then, if the FEN game is invalid, simply
          * reset the internal data.
          */
-        gupta_new_game();
+        gupta_new_game(pos);
     }
     return result;
 }
 
-void gupta_show_board()
+void gupta_show_board(const gupta_position_t *pos)
 {
     static const char set[] = {
         'q', 'r', 'b', 0, 'k', 'n', 'p', '.', 'P', 'N', 'K', 0, 'B', 'R', 'Q'
@@ -349,12 +403,15 @@ void gupta_show_board()
 
     for (sq = 0x70; ; )
     {
-        const piece_t *p = g_board[sq];
-        size_t index = (p ? p->_type : 0) + 7;
+        s8 p = pos->board[sq];
+        size_t index = p + 7;
         int value;
 
+        /* The bounds check is repeated outside of the assertion, as otherwise, without assertions,
+         * the compiler warns that the index may be out of bounds.
+         */
         UASSERT(index < ARRAY_SIZE(set));
-        value = set[index];
+        value = (index < ARRAY_SIZE(set)) ? set[index] : '?';
 
         /* Verify the correctness of the piece representation. The assertions should fail if the
          * piece representation is changed, so that we know we have to update the 'set' array (plus
@@ -363,8 +420,8 @@ void gupta_show_board()
          */
         if (p)
         {
-            int type = PIECE_TYPE(*p);
-            int side = PIECE_SIDE(*p);
+            int type = PIECE_TYPE(p);
+            int side = PIECE_SIDE(p);
 
             UASSERT(((side == BLACK) &&
                      (((type == PAWN)   && (value == 'p')) ||
@@ -403,7 +460,7 @@ void gupta_show_board()
 
     /* TODO remove */
 #if 0
-    printf("eval: %d\n", eval());
+    printf("eval: %d\n", eval(pos));
 #endif
 }
 
@@ -426,42 +483,20 @@ int is_dark_square(u8 location)
     return !is_light_square(location);
 }
 
-void reset_board_and_pieces()
+void reset_board(gupta_position_t *pos)
 {
-    clear_board(g_board);
-
-    reset_pieces();
-
-    g_board[0x00] = &g_pieces[0x01];
-    g_board[0x01] = &g_pieces[0x02];
-    g_board[0x02] = &g_pieces[0x03];
-    g_board[0x03] = &g_pieces[0x04];
-    g_board[0x04] = &g_pieces[0x00];
-    g_board[0x05] = &g_pieces[0x05];
-    g_board[0x06] = &g_pieces[0x06];
-    g_board[0x07] = &g_pieces[0x07];
-    g_board[0x10] = &g_pieces[0x08];
-    g_board[0x11] = &g_pieces[0x09];
-    g_board[0x12] = &g_pieces[0x0A];
-    g_board[0x13] = &g_pieces[0x0B];
-    g_board[0x14] = &g_pieces[0x0C];
-    g_board[0x15] = &g_pieces[0x0D];
-    g_board[0x16] = &g_pieces[0x0E];
-    g_board[0x17] = &g_pieces[0x0F];
-    g_board[0x70] = &g_pieces[0x11];
-    g_board[0x71] = &g_pieces[0x12];
-    g_board[0x72] = &g_pieces[0x13];
-    g_board[0x73] = &g_pieces[0x14];
-    g_board[0x74] = &g_pieces[0x10];
-    g_board[0x75] = &g_pieces[0x15];
-    g_board[0x76] = &g_pieces[0x16];
-    g_board[0x77] = &g_pieces[0x17];
-    g_board[0x60] = &g_pieces[0x18];
-    g_board[0x61] = &g_pieces[0x19];
-    g_board[0x62] = &g_pieces[0x1A];
-    g_board[0x63] = &g_pieces[0x1B];
-    g_board[0x64] = &g_pieces[0x1C];
-    g_board[0x65] = &g_pieces[0x1D];
-    g_board[0x66] = &g_pieces[0x1E];
-    g_board[0x67] = &g_pieces[0x1F];
+    static const s8 first_rank[] = {ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK};
+    u8 file;
+
+    clear_board(pos->board);
+
+    for (file = 0; file < 8; file++)
+    {
+        pos->board[0x00 + file] = +first_rank[file];
+        pos->board[0x10 + file] = +PAWN;
+        pos->board[0x60 + file] = -PAWN;
+        pos->board[0x70 + file] = -first_rank[file];
+    }
+
+    compute_bitboards(pos);
 }
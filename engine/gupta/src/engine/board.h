@@ -14,8 +14,11 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include "bitboard.h"
 #include "board_public.h"
+#include "move.h"
 #include "piece.h"
+#include "rules_public.h"
 
 /* The right side of the "board" is never accessed, but the memory offsets to it are used to detect
  * whether a square is valid or not. When AND-ed with 0x88, all offsets on the right side below
@@ -47,10 +50,66 @@
  *     ..                      | ..
  */
 
-extern piece_t *g_board[128];
+#define OCCUPIED_SQUARES(pos) ((pos)->bitboards[WHITE][NOPIECE] | (pos)->bitboards[BLACK][NOPIECE])
+#define KING_SQUARE(pos, side) (BB_LSB((pos)->bitboards[(side)][KING]))
 
+struct gupta_position
+{
+    /* The piece on every square, or NOPIECE. This 0x88 view of the position is the one moves and
+     * FEN strings are expressed in; the move generator and the evaluation use the bitboards
+     * instead.
+     */
+    s8 board[128];
+
+    /* The sets of squares occupied by each side's pieces, indexed by side and piece type. The set
+     * for piece type NOPIECE holds all of the side's pieces.
+     */
+    u64 bitboards[2][8];
+
+    /* Zobrist hash key of the position. See 'zobrist.h'. */
+    u64 hash_key;
+
+    gupta_result_t result;
+
+    int tside; /* Side whose turn it is. */
+    int oside; /* Side whose turn it is not (opposite/other side, hence 'oside'). */
+
+    /* The castling bits, see for example WHITE_KING_IS_NOT_AVAILABLE in 'rules.h'. */
+    u8 castling;
+
+    /* Booleans indicating whether a side castled. */
+    int castle_booleans[2];
+
+    /* Location of the square containing the pawn that can be captured by an En Passant move, or
+     * 0x88 if there is no such square.
+     */
+    u8 en_passant;
+
+    /* Number of halfmoves since the last capture or pawn move, for the fifty-move rule. A null
+     * move resets it as well, as no position before a null move can be repeated after it in a
+     * real game.
+     */
+    int halfmove_clock;
+
+    /* The number of pieces of each side and kind, see 'material.h'. */
+    u64 material_key;
+
+    /* Sums of 'g_piece_square_values' over all the pieces of each side, indexed by side and game
+     * stage. Like 'material_key', these are not computed by eval(), but are instead updated
+     * incrementally whenever a piece is added to or removed from the board.
+     */
+    int eval_sums[2][2];
+
+    size_t    history_idx;
+    history_t *history_stack;
+    size_t    history_stack_num_elements;
+};
+
+void copy_position(gupta_position_t *dst, const gupta_position_t *src);
 int is_light_square(u8 location);
 int is_dark_square(u8 location);
-void reset_board_and_pieces(void);
+void reset_board(gupta_position_t *pos);
+void set_board_from_pieces(gupta_position_t *pos, const s8 *pieces, const u8 *locations,
+                           size_t num_pieces, int side);
 
 #endif /* !defined(BOARD_H) */
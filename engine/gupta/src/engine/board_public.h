@@ -16,9 +16,18 @@
 
 #include <stddef.h>
 
+/* A position holds the complete state of a game: the pieces on the board, the side to move, the
+ * castling and En Passant availabilities, and the moves made so far (so that they can be undone).
+ * Positions are independent of each other, so any number of them may be used at once, for
+ * example one for every search thread.
+ */
+typedef struct gupta_position gupta_position_t;
+
+gupta_position_t *gupta_create_position(void);
+void gupta_destroy_position(gupta_position_t *pos);
 char *gupta_fen_buffer(void);
 size_t gupta_fen_buffer_size(void);
-int gupta_set_board_from_fen(const char *fen);
-void gupta_show_board(void);
+int gupta_set_board_from_fen(gupta_position_t *pos, const char *fen);
+void gupta_show_board(const gupta_position_t *pos);
 
 #endif /* !defined(BOARD_PUBLIC_H) */
@@ -0,0 +1,385 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Opening book. Holds the moves to play in known positions, such as the initial position, so that
+ * they are played right away rather than searched.
+ *
+ * A book file consists of 16-byte entries in the layout of Polyglot books: a 64-bit position key,
+ * a 16-bit move, a 16-bit weight and a 32-bit learning value (unused), all big-endian, sorted by
+ * position key. A position has an entry for every book move, and its moves are played in
+ * proportion to their weights. The moves are encoded as in Polyglot books as well: bits 0-5 hold
+ * the destination square and bits 6-11 the source square (both as rank * 8 + file), bits 12-14
+ * the promotion piece (1 for a knight up to 4 for a queen), and castling is encoded as the king
+ * capturing its own rook. The position key, however, is the hash key of the position (see
+ * 'zobrist.h') rather than the Polyglot key, so books have to be built with gupta_write_book(),
+ * for example by the 'gupta-book' program (see 'src/book/book.c').
+ *
+ * The book file is mapped into memory, see 'file_map.c'.
+ */
+
+#include "book.h"
+#include "bitboard.h"
+#include "board.h"
+#include "common.h"
+#include "enforce.h"
+#include "file_map.h"
+#include "move.h"
+#include "piece.h"
+#include "uassert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BOOK_ENTRY_SIZE 16
+
+/* The most moves of a position that are considered, see book_probe(). */
+#define BOOK_MOVES_MAX 64
+
+/* The promotion pieces, indexed by their codes in the encoded moves. */
+static const int promotions[] = {
+    PROMOTE_NONE, PROMOTE_KNIGHT, PROMOTE_BISHOP, PROMOTE_ROOK, PROMOTE_QUEEN
+};
+
+/* The mapped book file, or NULL if no book is open. */
+static const unsigned char *book_entries = NULL;
+static size_t book_num_entries = 0;
+
+typedef struct
+{
+    u64 key,
+        weight;
+    unsigned int move,
+                 num_games;
+} builder_entry_t;
+
+struct gupta_book_builder
+{
+    builder_entry_t *entries;
+    size_t num_entries,
+           max_entries;
+};
+
+static u64 read_big_endian(const unsigned char *p, size_t size)
+{
+    u64 value = 0;
+
+    while (size--)
+        value = (value << 8) | *p++;
+
+    return value;
+}
+
+static void write_big_endian(unsigned char *p, u64 value, size_t size)
+{
+    while (size--)
+    {
+        p[size] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+static u64 entry_key(size_t idx)
+{
+    return read_big_endian(&book_entries[idx * BOOK_ENTRY_SIZE], 8);
+}
+
+/* Returns the index of the first entry of the book with a key of at least 'key'. */
+static size_t find_first_entry(u64 key)
+{
+    size_t low = 0,
+           high = book_num_entries;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (entry_key(middle) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+/* Returns whether move 'm' of position 'pos' is a castling move, which moves the king two squares
+ * from its initial square.
+ */
+static int is_castling(const gupta_position_t *pos, const move_t *m)
+{
+    return (PIECE_TYPE(pos->board[m->from]) == KING) && ((m->from & 0x0F) == 4) &&
+           (abs(m->to - m->from) == 2);
+}
+
+static unsigned int encode_move(const gupta_position_t *pos, const move_t *m)
+{
+    unsigned int promotion = 0;
+    u8 to = m->to;
+
+    if (is_castling(pos, m))
+        to = (m->to > m->from) ? m->from + 3 : m->from - 4;
+
+    while ((promotion < ARRAY_SIZE(promotions)) && (promotions[promotion] != m->promote))
+        promotion++;
+    UASSERT(promotion < ARRAY_SIZE(promotions));
+
+    return SQ64(to) | (SQ64(m->from) << 6) | (promotion << 12);
+}
+
+/* Decodes a move of position 'pos'. Returns 0 if the encoded move is invalid. */
+static int decode_move(const gupta_position_t *pos, unsigned int code, move_t *m)
+{
+    unsigned int promotion = (code >> 12) & 0x07;
+
+    if (promotion >= ARRAY_SIZE(promotions))
+        return 0;
+
+    m->from = SQ88((code >> 6) & 0x3F);
+    m->to = SQ88(code & 0x3F);
+    m->promote = promotions[promotion];
+
+    /* The king capturing its own rook is a castling move. */
+    if ((PIECE_TYPE(pos->board[m->from]) == KING) && ((m->from & 0x0F) == 4) &&
+        (pos->board[m->to] == ((pos->board[m->from] > 0) ? +ROOK : -ROOK)))
+    {
+        m->to = (m->to > m->from) ? m->from + 2 : m->from - 2;
+    }
+
+    return 1;
+}
+
+/* Looks up position 'pos' in the book. If the position has book moves, one of them is stored in
+ * 'm', chosen with the 'random' number in proportion to the weights of the moves. Returns 0 if no
+ * book is open, or if the position has no book moves.
+ */
+int book_probe(gupta_position_t *pos, u64 random, move_t *m)
+{
+    move_t moves[BOOK_MOVES_MAX];
+    u64 weights[BOOK_MOVES_MAX],
+        total_weight = 0;
+    size_t num_moves = 0,
+           idx;
+
+    if (!book_entries)
+        return 0;
+
+    for (idx = find_first_entry(pos->hash_key);
+         (idx < book_num_entries) && (entry_key(idx) == pos->hash_key) &&
+         (num_moves < BOOK_MOVES_MAX);
+         idx++)
+    {
+        const unsigned char *entry = &book_entries[idx * BOOK_ENTRY_SIZE];
+        u64 weight = read_big_endian(&entry[10], 2);
+        move_t move;
+
+        if ((weight == 0) || !decode_move(pos, (unsigned int)read_big_endian(&entry[8], 2), &move))
+            continue;
+
+        /* The moves of another position with the same key (or of a corrupt book) are most likely
+         * illegal.
+         */
+        if (!make_move(pos, &move, MOVE_STRICT_VALIDATION))
+            continue;
+        gupta_undo_move(pos);
+
+        moves[num_moves] = move;
+        weights[num_moves] = weight;
+        total_weight += weight;
+        num_moves++;
+    }
+
+    if (num_moves == 0)
+        return 0;
+
+    random %= total_weight;
+    for (idx = 0; random >= weights[idx]; idx++)
+        random -= weights[idx];
+
+    *m = moves[idx];
+    return 1;
+}
+
+void gupta_close_book()
+{
+    if (!book_entries)
+        return;
+
+    unmap_file(book_entries, book_num_entries * BOOK_ENTRY_SIZE);
+
+    book_entries = NULL;
+    book_num_entries = 0;
+}
+
+/* Opens the book file at 'path', instead of any book that was open. Returns 0 if the file couldn't
+ * be opened, in which case no book is open.
+ */
+int gupta_open_book(const char *path)
+{
+    const void *view;
+    size_t size;
+
+    gupta_close_book();
+
+    view = map_file(path, &size);
+    if (!view)
+        return 0;
+
+    if (size % BOOK_ENTRY_SIZE != 0)
+    {
+        unmap_file(view, size);
+        return 0;
+    }
+
+    book_entries = view;
+    book_num_entries = size / BOOK_ENTRY_SIZE;
+
+    return 1;
+}
+
+/* Adds move 'm' of position 'pos', as played in a game, to the book that is being built. The
+ * weights of the games in which a move was played add up, see gupta_write_book().
+ */
+void gupta_add_book_move(gupta_book_builder_t *b, const gupta_position_t *pos, const move_t *m,
+                         unsigned int weight)
+{
+    builder_entry_t *entry;
+
+    if (b->num_entries == b->max_entries)
+    {
+        size_t max_entries = b->max_entries ? b->max_entries * 2 : 1024;
+        builder_entry_t *p = realloc(b->entries, max_entries * sizeof(*p));
+
+        if (!p)
+            enforce(0 && "out of memory");
+
+        b->entries = p;
+        b->max_entries = max_entries;
+    }
+
+    entry = &b->entries[b->num_entries++];
+    entry->key = pos->hash_key;
+    entry->weight = weight;
+    entry->move = encode_move(pos, m);
+    entry->num_games = 1;
+}
+
+gupta_book_builder_t *gupta_create_book_builder()
+{
+    gupta_book_builder_t *b = calloc(1, sizeof(*b));
+
+    if (!b)
+        enforce(0 && "out of memory");
+
+    return b;
+}
+
+void gupta_destroy_book_builder(gupta_book_builder_t *b)
+{
+    free(b->entries);
+    free(b);
+}
+
+static int compare_builder_entries(const void *a, const void *b)
+{
+    const builder_entry_t *x = a,
+                          *y = b;
+
+    if (x->key != y->key)
+        return (x->key < y->key) ? -1 : 1;
+    if (x->move != y->move)
+        return (x->move < y->move) ? -1 : 1;
+    return 0;
+}
+
+/* Writes the moves added to book builder 'b' to the book file at 'path', leaving out the moves
+ * that were played in fewer than 'min_games' games, or that have no weight. The number of entries
+ * written is stored in 'num_entries', if it isn't NULL. Returns 0 if the file couldn't be written.
+ */
+int gupta_write_book(gupta_book_builder_t *b, const char *path, unsigned int min_games,
+                     size_t *num_entries)
+{
+    FILE *f;
+    size_t i,
+           j,
+           n = 0;
+    int result = 0;
+
+    qsort(b->entries, b->num_entries, sizeof(*b->entries), compare_builder_entries);
+
+    /* Merge the entries of the same move in the same position. */
+    for (i = 0, j = 0; i < b->num_entries; i++)
+    {
+        if ((j > 0) && (compare_builder_entries(&b->entries[j - 1], &b->entries[i]) == 0))
+        {
+            b->entries[j - 1].weight += b->entries[i].weight;
+            b->entries[j - 1].num_games += b->entries[i].num_games;
+        }
+        else
+            b->entries[j++] = b->entries[i];
+    }
+    b->num_entries = j;
+
+    f = fopen(path, "wb");
+    if (!f)
+        goto done;
+
+    for (i = 0; i < b->num_entries; i = j)
+    {
+        u64 max_weight = 0;
+        size_t end;
+
+        for (end = i; (end < b->num_entries) && (b->entries[end].key == b->entries[i].key); end++)
+        {
+            if ((b->entries[end].num_games >= min_games) && (b->entries[end].weight > max_weight))
+                max_weight = b->entries[end].weight;
+        }
+
+        for (j = i; j < end; j++)
+        {
+            const builder_entry_t *entry = &b->entries[j];
+            unsigned char data[BOOK_ENTRY_SIZE] = {0};
+            u64 weight = entry->weight;
+
+            if ((entry->num_games < min_games) || (weight == 0))
+                continue;
+
+            /* The weights are 16-bit, so those of a position are scaled down if need be, keeping
+             * their proportions.
+             */
+            if (max_weight > 0xFFFF)
+            {
+                weight = weight * 0xFFFF / max_weight;
+                if (weight == 0)
+                    weight = 1;
+            }
+
+            write_big_endian(&data[0], entry->key, 8);
+            write_big_endian(&data[8], entry->move, 2);
+            write_big_endian(&data[10], weight, 2);
+            if (fwrite(data, sizeof(data), 1, f) != 1)
+                goto done;
+            n++;
+        }
+    }
+
+    result = 1;
+
+done:
+    if (f && (fclose(f) != 0))
+        result = 0;
+    if (num_entries)
+        *num_entries = n;
+    return result;
+}
@@ -11,11 +11,14 @@
     If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
 
-#ifndef MOVE_DELTAS_H
-#define MOVE_DELTAS_H
 
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "book_public.h"
+#include "move_public.h"
 #include "types.h"
 
-extern const s8 *g_move_deltas[8];
+int book_probe(gupta_position_t *pos, u64 random, move_t *m);
 
-#endif /* !defined(MOVE_DELTAS_H) */
+#endif /* !defined(BOOK_H) */
@@ -0,0 +1,41 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef BOOK_PUBLIC_H
+#define BOOK_PUBLIC_H
+
+#include "board_public.h"
+#include "move_public.h"
+
+#include <stddef.h>
+
+/* The opening book that the CECP interface opens at startup, if it exists. */
+#define GUPTA_BOOK_FILE_DEFAULT "gupta-book.bin"
+
+/* A book builder collects the moves played in a set of games, and writes them to a book file, see
+ * gupta_write_book().
+ */
+typedef struct gupta_book_builder gupta_book_builder_t;
+
+void gupta_close_book(void);
+int gupta_open_book(const char *path);
+
+void gupta_add_book_move(gupta_book_builder_t *b, const gupta_position_t *pos, const move_t *m,
+                         unsigned int weight);
+gupta_book_builder_t *gupta_create_book_builder(void);
+void gupta_destroy_book_builder(gupta_book_builder_t *b);
+int gupta_write_book(gupta_book_builder_t *b, const char *path, unsigned int min_games,
+                     size_t *num_entries);
+
+#endif /* !defined(BOOK_PUBLIC_H) */
@@ -13,13 +13,16 @@
 
 #include "eval.h"
 #include "bitops.h"
+#include "board.h"
 #include "common.h"
+#include "material.h"
 #include "piece.h"
 #include "rules.h"
 
 #include <stdlib.h>
+#include <string.h>
 
-static int piece_scores[] = {
+const int g_piece_values[] = {
       0,
     100, /* Pawn. */
     300, /* Knight. */
@@ -133,72 +136,102 @@ static int king_endgame_location_bonuses[] = {
           0,   10,   20,   30,   30,   20,   10,    0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
-int eval()
-{
-    size_t i;
-    int    scores[2] = {0, 0}; /* Scores for each side. */
-    int    endgame_booleans[2] = {0, 0}; /* End-game booleans for each side. */
+int g_piece_square_values[2][8][64][2];
 
-    /* First count the material. This is used to determine in which stage the game is in (opening,
-     * middle-game, end-game). Note that for each side, the game may be considered to be in a
-     * different stage.
-     */
-    for (i = 0; i < ARRAY_SIZE(g_pieces); i++)
+static int location_bonus(int side, int type, u8 location, int stage)
+{
+    switch (type)
     {
-        const piece_t *p = &g_pieces[i];
-        int side = PIECE_SIDE(*p);
-
-        if (!p->is_captured)
-            scores[side] += piece_scores[PIECE_TYPE(*p)];
+    case PAWN:
+        return PAWN_LOCATION_BONUS(side, location);
+    case KNIGHT:
+    case BISHOP:
+        return knight_and_bishop_location_bonuses[location];
+    case KING:
+        if (stage == EVAL_ENDGAME)
+            return king_endgame_location_bonuses[location];
+        return king_location_bonuses_list[side][location];
+    default:
+        return 0;
     }
+}
 
-#define ENDGAME_VALUE 1200
-    if (scores[WHITE] <= ENDGAME_VALUE)
-        endgame_booleans[WHITE] = 1;
-    if (scores[BLACK] <= ENDGAME_VALUE)
-        endgame_booleans[BLACK] = 1;
+void init_eval()
+{
+    int side,
+        type,
+        sq,
+        stage;
 
-    /* Estimate the worth of each piece. */
-    for (i = 0; i < ARRAY_SIZE(g_pieces); i++)
+    for (side = 0; side < 2; side++)
     {
-        const piece_t *p = &g_pieces[i];
-        int side = PIECE_SIDE(*p);
-
-        if (!p->is_captured)
+        for (type = PAWN; type <= QUEEN; type++)
         {
-            int type = PIECE_TYPE(*p);
-            int score = 0;
-
-            if (type == PAWN)
-                score += PAWN_LOCATION_BONUS(side, p->location);
-            else if (type == KNIGHT)
-                score += knight_and_bishop_location_bonuses[p->location];
-            else if (type == BISHOP)
-                score += knight_and_bishop_location_bonuses[p->location];
-            else if (type == KING)
+            for (sq = 0; sq < 64; sq++)
             {
-                if (endgame_booleans[side])
-                    score += king_endgame_location_bonuses[p->location];
-                else
-                    score += king_location_bonuses_list[side][p->location];
+                for (stage = EVAL_MIDDLEGAME; stage <= EVAL_ENDGAME; stage++)
+                {
+                    g_piece_square_values[side][type][sq][stage] =
+                        g_piece_values[type] + location_bonus(side, type, SQ88(sq), stage);
+                }
             }
+        }
+    }
+}
+
+void compute_eval_sums(gupta_position_t *pos)
+{
+    int side,
+        type;
 
-            scores[side] += score;
+    memset(pos->eval_sums, 0, sizeof(pos->eval_sums));
+
+    for (side = 0; side < 2; side++)
+    {
+        for (type = PAWN; type <= QUEEN; type++)
+        {
+            u64 pieces;
+
+            for (pieces = pos->bitboards[side][type]; pieces; BB_CLEAR_LSB(pieces))
+                EVAL_ADD_PIECE(pos, side, type, BB_LSB(pieces), +1);
         }
     }
+}
+
+int eval(const gupta_position_t *pos)
+{
+    const material_entry_t *material = material_probe(pos);
+    int scores[2]; /* Scores for each side. */
+    int side,
+        score;
+
+    /* Taper between the middle-game and end-game sums, using the side's material to determine in
+     * which stage the game is in. Note that for each side, the game may be considered to be in a
+     * different stage.
+     */
+    for (side = 0; side < 2; side++)
+    {
+        const int *sums = pos->eval_sums[side];
+        int phase = material->phase[side];
 
+        scores[side] = (sums[EVAL_MIDDLEGAME] * phase +
+                        sums[EVAL_ENDGAME] * (MATERIAL_PHASE_MAX - phase))
+                       / MATERIAL_PHASE_MAX;
+    }
     /* When losing a castling capability (and having not used it), invoke a penalty for wasting
      * that castling move.
      */
 #define CASTLING_WASTED 20
-    if (!g_castle_booleans[WHITE] && BIT_IS_ANY_SET(g_castling, g_castling_masks[WHITE][0]))
+    if (!pos->castle_booleans[WHITE] && BIT_IS_ANY_SET(pos->castling, g_castling_masks[WHITE][0]))
         scores[WHITE] -= CASTLING_WASTED; /* Kingside castling move wasted. */
-    if (!g_castle_booleans[WHITE] && BIT_IS_ANY_SET(g_castling, g_castling_masks[WHITE][1]))
+    if (!pos->castle_booleans[WHITE] && BIT_IS_ANY_SET(pos->castling, g_castling_masks[WHITE][1]))
         scores[WHITE] -= CASTLING_WASTED; /* Queenside castling move wasted. */
-    if (!g_castle_booleans[BLACK] && BIT_IS_ANY_SET(g_castling, g_castling_masks[BLACK][0]))
+    if (!pos->castle_booleans[BLACK] && BIT_IS_ANY_SET(pos->castling, g_castling_masks[BLACK][0]))
         scores[BLACK] -= CASTLING_WASTED; /* Kingside castling move wasted. */
-    if (!g_castle_booleans[BLACK] && BIT_IS_ANY_SET(g_castling, g_castling_masks[BLACK][1]))
+    if (!pos->castle_booleans[BLACK] && BIT_IS_ANY_SET(pos->castling, g_castling_masks[BLACK][1]))
         scores[BLACK] -= CASTLING_WASTED; /* Queenside castling move wasted. */
 
-    return scores[g_tside] - scores[g_oside];
+    /* Only part of the advantage counts in endgames that are hard to win. */
+    score = scores[pos->tside] - scores[pos->oside];
+    return score * material->scale[score > 0 ? pos->tside : pos->oside] / MATERIAL_SCALE_NORMAL;
 }
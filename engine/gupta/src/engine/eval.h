@@ -14,6 +14,35 @@
 #ifndef EVAL_H
 #define EVAL_H
 
-int eval(void);
+#include "board_public.h"
+#include "compiler_specific.h"
+
+/* Material values, indexable by piece type. The king is priceless, and hence has a value of 0. */
+extern const int g_piece_values[];
+
+enum
+{
+    EVAL_MIDDLEGAME,
+    EVAL_ENDGAME
+};
+
+/* The material value of a piece plus its location bonus, indexed by side, piece type, square and
+ * game stage (EVAL_MIDDLEGAME or EVAL_ENDGAME).
+ */
+extern int g_piece_square_values[2][8][64][2];
+
+/* Adds ('sign' is +1) or removes ('sign' is -1) the piece of 'side' and 'type' on square 'sq'
+ * (0..63) to or from the evaluation sums of position 'pos'.
+ */
+#define EVAL_ADD_PIECE(pos, side, type, sq, sign)                                                 \
+    MACRO_BEGIN                                                                                   \
+    const int *values_ = g_piece_square_values[(side)][(type)][(sq)];                             \
+    (pos)->eval_sums[(side)][EVAL_MIDDLEGAME] += (sign) * values_[EVAL_MIDDLEGAME];               \
+    (pos)->eval_sums[(side)][EVAL_ENDGAME] += (sign) * values_[EVAL_ENDGAME];                     \
+    MACRO_END
+
+void init_eval(void);
+void compute_eval_sums(gupta_position_t *pos);
+int eval(const gupta_position_t *pos);
 
 #endif /* !defined(EVAL_H) */
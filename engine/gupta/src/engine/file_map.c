@@ -0,0 +1,100 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Read-only memory mappings of files, such as the opening book and the endgame tablebases. Mapping
+ * a file, rather than reading it, takes no time, and only the parts of it that are accessed are
+ * ever read from disk. The operating system shares the mapped pages between processes, and may
+ * drop them again when memory runs short.
+ */
+
+#include "file_map.h"
+#include "types.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else /* !defined(_WIN32) */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+/* Maps the file at 'path' into memory, and stores its size in 'size'. Returns NULL if the file
+ * couldn't be mapped, which includes empty files.
+ */
+const void *map_file(const char *path, size_t *size)
+{
+#ifdef _WIN32
+    HANDLE file,
+           mapping = NULL;
+    LARGE_INTEGER file_size;
+    void *view = NULL;
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (GetFileSizeEx(file, &file_size) && (file_size.QuadPart > 0) &&
+        ((u64)file_size.QuadPart <= (size_t)-1))
+    {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+
+    /* The view keeps the file mapped once the handles are closed. */
+    if (mapping)
+    {
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+
+    if (!view)
+        return NULL;
+
+    *size = (size_t)file_size.QuadPart;
+    return view;
+#else /* !defined(_WIN32) */
+    struct stat st;
+    void *view = MAP_FAILED;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    /* The mapping remains once the file is closed. */
+    if ((fstat(fd, &st) == 0) && (st.st_size > 0) && ((u64)st.st_size <= (size_t)-1))
+        view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return NULL;
+
+    *size = (size_t)st.st_size;
+    return view;
+#endif /* !defined(_WIN32) */
+}
+
+/* Unmaps a file mapped by map_file(), which returned 'view' and 'size'. */
+void unmap_file(const void *view, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile((LPCVOID)view);
+#else /* !defined(_WIN32) */
+    munmap((void *)view, size);
+#endif /* !defined(_WIN32) */
+}
@@ -11,15 +11,13 @@
     If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
 */
 
-#ifndef RANGE_H
-#define RANGE_H
+
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
 
 #include <stddef.h>
 
-typedef struct
-{
-    size_t begin,
-           end;
-} range_t;
+const void *map_file(const char *path, size_t *size);
+void unmap_file(const void *view, size_t size);
 
-#endif /* !defined(RANGE_H) */
+#endif /* !defined(FILE_MAP_H) */
@@ -12,23 +12,29 @@
 */
 
 #include "gupta.h"
-#include "move.h"
+#include "bitboard.h"
+#include "eval.h"
+#include "material.h"
+#include "tablebase.h"
+#include "ttable.h"
+#include "zobrist.h"
 
-#include <stdlib.h>
+void gupta_init()
+{
+    init_bitboards();
+    init_eval();
+    init_material();
+    init_ttable();
+    init_zobrist();
+    init_tablebases();
+}
 
+/* Frees the resources shared by all positions and searches. The positions and searches themselves
+ * must be destroyed separately, see gupta_destroy_position() and gupta_destroy_search().
+ */
 void gupta_uninit()
 {
-    if (g_move_stack)
-    {
-        free(g_move_stack);
-        g_move_stack = NULL;
-        g_move_stack_num_elements = 0;
-    }
-
-    if (g_history_stack)
-    {
-        free(g_history_stack);
-        g_history_stack = NULL;
-        g_history_stack_num_elements = 0;
-    }
+    tt_free();
+    gupta_close_book();
+    gupta_close_tablebases();
 }
@@ -13,19 +13,37 @@
 
 /*
  * Public Gupta interface. Exposes everything necessary for the CECP (Chess Engine Communication
- * Protocol) interface.
+ * Protocol) interface, and for programs that embed the engine by linking to the libgupta library.
+ *
+ * A minimal embedding calls gupta_init(), creates a position and a search, sets the position with
+ * gupta_set_board_from_fen() and gupta_make_move(), and calls gupta_find_move(). The search
+ * reports its progress and its best move through the callbacks in 'search_public.h', and can be
+ * stopped from another thread with gupta_abort_search(). gupta_perft() counts the positions of
+ * the game tree, to verify the move generator.
  */
 
 #ifndef GUPTA_H
 #define GUPTA_H
 
+#include "bench_public.h"
 #include "board_public.h"
+#include "book_public.h"
 #include "move_public.h"
+#include "perft_public.h"
 #include "rules_public.h"
+#include "san_public.h"
 #include "search_public.h"
+#include "tablebase_public.h"
+#include "ttable_public.h"
 
 #include <stddef.h>
 
+/* Incremented whenever a change to this interface breaks existing programs that embed the
+ * engine.
+ */
+#define GUPTA_API_VERSION 1
+
+void gupta_init(void);
 void gupta_uninit(void);
 
 #endif /* !defined(GUPTA_H) */
@@ -0,0 +1,281 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * The material table caches what follows from the material of a position alone: whether there is
+ * enough of it to checkmate, the game phase, and how much an advantage counts in endgames that are
+ * known to be hard to win. A position's material key (see 'material.h') is kept up to date by
+ * making and undoing moves, so looking these up costs a single table access, rather than a count of
+ * the pieces at every node.
+ *
+ * Every thread has its own table, so that the threads of a search need no locking. Entries are
+ * computed whenever the material isn't found in the table.
+ */
+
+#include "material.h"
+#include "bitboard.h"
+#include "board.h"
+#include "eval.h"
+#include "piece.h"
+
+#define MATERIAL_TABLE_BITS 12
+#define MATERIAL_TABLE_SIZE (1 << MATERIAL_TABLE_BITS)
+
+/* Set in the key of every entry that was computed, so that an empty entry is never mistaken for
+ * the material of two bare kings. The material keys themselves use only the lower 48 bits.
+ */
+#define ENTRY_IS_USED (1ULL << 63)
+
+/* The material, not counting the king, below which a side is considered to be in the endgame,
+ * and above which it is considered to be in the middlegame. In between, the phase is proportional
+ * to the material.
+ */
+#define ENDGAME_VALUE    1200
+#define MIDDLEGAME_VALUE (ENDGAME_VALUE + MATERIAL_PHASE_MAX)
+
+u64 g_material_units[2][8][64];
+
+static THREAD_LOCAL material_entry_t material_table[MATERIAL_TABLE_SIZE];
+
+static int material_kind(int type, int sq)
+{
+    switch (type)
+    {
+    case PAWN:
+        return MATERIAL_PAWN;
+    case KNIGHT:
+        return MATERIAL_KNIGHT;
+    case BISHOP:
+        return (BB_SQUARE(sq) & BB_LIGHT_SQUARES) ? MATERIAL_LIGHT_BISHOP : MATERIAL_DARK_BISHOP;
+    case ROOK:
+        return MATERIAL_ROOK;
+    case QUEEN:
+        return MATERIAL_QUEEN;
+    default:
+        return -1;
+    }
+}
+
+void init_material()
+{
+    int side,
+        type,
+        sq;
+
+    for (side = 0; side < 2; side++)
+    {
+        for (type = PAWN; type <= QUEEN; type++)
+        {
+            for (sq = 0; sq < 64; sq++)
+            {
+                int kind = material_kind(type, sq);
+
+                g_material_units[side][type][sq] =
+                    (kind < 0) ? 0 : 1ULL << ((side * MATERIAL_NUM_KINDS + kind) * 4);
+            }
+        }
+    }
+}
+
+u64 compute_material_key(const gupta_position_t *pos)
+{
+    u64 key = 0;
+    int side,
+        type;
+
+    for (side = 0; side < 2; side++)
+    {
+        for (type = PAWN; type <= QUEEN; type++)
+        {
+            u64 pieces;
+
+            for (pieces = pos->bitboards[side][type]; pieces; BB_CLEAR_LSB(pieces))
+                key += g_material_units[side][type][BB_LSB(pieces)];
+        }
+    }
+
+    return key;
+}
+
+/* The game is considered to be a draw by insufficient material only under any of the following
+ * conditions:
+ *     - Both sides only have a king.
+ *     - One side only has a king and bishop, the other only a king.
+ *     - One side only has a king and knight, the other only a king.
+ *     - Both sides only have a king and bishops of the same type.
+ */
+static int is_insufficient_material(u64 key)
+{
+    int knights[2],
+        has_light_square_bishop[2],
+        has_dark_square_bishop[2],
+        side;
+
+    for (side = 0; side < 2; side++)
+    {
+        if (MATERIAL_COUNT(key, side, MATERIAL_QUEEN) || MATERIAL_COUNT(key, side, MATERIAL_ROOK) ||
+            MATERIAL_COUNT(key, side, MATERIAL_PAWN))
+        {
+            /* At least one side has mating material or potential mating material. */
+            return 0;
+        }
+
+        knights[side] = MATERIAL_COUNT(key, side, MATERIAL_KNIGHT);
+        has_light_square_bishop[side] = MATERIAL_COUNT(key, side, MATERIAL_LIGHT_BISHOP) != 0;
+        has_dark_square_bishop[side] = MATERIAL_COUNT(key, side, MATERIAL_DARK_BISHOP) != 0;
+    }
+
+    /* Do the following checks for both sides. */
+    for (side = 0; side < 2; side++)
+    {
+        int other_side = side ^ 1,
+            other_side_has_nothing = (knights[other_side] == 0) &&
+                                     (!has_light_square_bishop[other_side] &&
+                                      !has_dark_square_bishop[other_side]),
+            side_has_only_one_type_of_bishop = has_light_square_bishop[side] ^
+                                               has_dark_square_bishop[side],
+            other_side_has_only_one_type_of_bishop = has_light_square_bishop[other_side] ^
+                                                     has_dark_square_bishop[other_side];
+
+        /* Do both sides have no knights, and only bishops of the same type (that is, the bishops
+         * of one side are of the same type as those of the other)?
+         */
+        if ((knights[side] == 0) &&
+            side_has_only_one_type_of_bishop &&
+            (knights[other_side] == 0) &&
+            other_side_has_only_one_type_of_bishop &&
+            /* If both sides have bishops of only one type each, then the bishops of both sides are
+             * of the same type if both have (or both lack) light square bishops.
+             */
+            (has_light_square_bishop[side] == has_light_square_bishop[other_side]))
+        {
+            return 1;
+        }
+        /* Does one side only have one or fewer knights and no bishops, and the other nothing? */
+        else if ((knights[side] <= 1) &&
+                 (!has_light_square_bishop[side] && !has_dark_square_bishop[side]) &&
+                 other_side_has_nothing)
+        {
+            return 1;
+        }
+        /* Does one side have no knights and no bishop pairs (in other words, does one side have no
+         * knights and no bishops or only bishops of the same type), and the other nothing?
+         */
+        else if ((knights[side] == 0) &&
+                 !(has_light_square_bishop[side] && has_dark_square_bishop[side]) &&
+                 other_side_has_nothing)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Returns the scale factor of the advantage of 'side', given the number of pieces of each kind
+ * 'counts', and the material besides the kings and the pawns 'piece_material', of both sides.
+ */
+static int compute_scale(int side, int counts[2][MATERIAL_NUM_KINDS], const int *piece_material)
+{
+    int other_side = side ^ 1,
+        bishops[2],
+        i;
+
+    /* Without pawns, a side that is at most a minor piece ahead rarely wins, and without a rook's
+     * worth of material (two knights, say) it can't force checkmate at all.
+     */
+    if ((counts[side][MATERIAL_PAWN] == 0) &&
+        (piece_material[side] - piece_material[other_side] <= g_piece_values[BISHOP]))
+    {
+        if (piece_material[side] < g_piece_values[ROOK])
+            return 0;
+        return (piece_material[other_side] <= g_piece_values[BISHOP]) ? 2 : 4;
+    }
+
+    /* Likewise for two knights against a bare king. */
+    if ((counts[side][MATERIAL_PAWN] == 0) &&
+        (piece_material[side] == counts[side][MATERIAL_KNIGHT] * g_piece_values[KNIGHT]) &&
+        (counts[side][MATERIAL_KNIGHT] <= 2) && (piece_material[other_side] == 0) &&
+        (counts[other_side][MATERIAL_PAWN] == 0))
+    {
+        return 0;
+    }
+
+    /* With only a bishop each, on squares of different colors, neither side can contest the
+     * squares that the other's bishop controls, so extra pawns are often not enough to win.
+     */
+    for (i = 0; i < 2; i++)
+        bishops[i] = counts[i][MATERIAL_LIGHT_BISHOP] + counts[i][MATERIAL_DARK_BISHOP];
+    if ((bishops[WHITE] == 1) && (bishops[BLACK] == 1) &&
+        (piece_material[WHITE] == g_piece_values[BISHOP]) &&
+        (piece_material[BLACK] == g_piece_values[BISHOP]) &&
+        (counts[WHITE][MATERIAL_LIGHT_BISHOP] != counts[BLACK][MATERIAL_LIGHT_BISHOP]))
+    {
+        return MATERIAL_SCALE_NORMAL / 2;
+    }
+
+    return MATERIAL_SCALE_NORMAL;
+}
+
+static void compute_entry(material_entry_t *entry, u64 key)
+{
+    static const int piece_types[] = {PAWN, KNIGHT, BISHOP, BISHOP, ROOK, QUEEN};
+    int counts[2][MATERIAL_NUM_KINDS],
+        piece_material[2],
+        side,
+        kind;
+
+    for (side = 0; side < 2; side++)
+    {
+        int phase;
+
+        piece_material[side] = 0;
+        for (kind = 0; kind < MATERIAL_NUM_KINDS; kind++)
+        {
+            counts[side][kind] = MATERIAL_COUNT(key, side, kind);
+            if (kind != MATERIAL_PAWN)
+                piece_material[side] += counts[side][kind] * g_piece_values[piece_types[kind]];
+        }
+
+        phase = piece_material[side] + counts[side][MATERIAL_PAWN] * g_piece_values[PAWN] -
+                ENDGAME_VALUE;
+        if (phase < 0)
+            phase = 0;
+        else if (phase > MIDDLEGAME_VALUE - ENDGAME_VALUE)
+            phase = MIDDLEGAME_VALUE - ENDGAME_VALUE;
+        entry->phase[side] = phase;
+    }
+
+    for (side = 0; side < 2; side++)
+        entry->scale[side] = (u8)compute_scale(side, counts, piece_material);
+
+    entry->is_insufficient_material = (u8)is_insufficient_material(key);
+    entry->key = key | ENTRY_IS_USED;
+}
+
+/* Returns the entry of the material of position 'pos'. The entry stays valid until the next call
+ * by the same thread.
+ */
+const material_entry_t *material_probe(const gupta_position_t *pos)
+{
+    u64 key = pos->material_key;
+    /* Multiplying spreads the counts over the upper bits, which are used as the index. */
+    material_entry_t *entry =
+        &material_table[(key * 0x9E3779B97F4A7C15ULL) >> (64 - MATERIAL_TABLE_BITS)];
+
+    if (entry->key != (key | ENTRY_IS_USED))
+        compute_entry(entry, key);
+
+    return entry;
+}
@@ -0,0 +1,83 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "board_public.h"
+#include "compiler_specific.h"
+#include "types.h"
+
+/* The kinds of pieces that the material key counts. Bishops are told apart by the color of their
+ * square, as that color decides which squares they can ever attack.
+ */
+enum
+{
+    MATERIAL_PAWN,
+    MATERIAL_KNIGHT,
+    MATERIAL_LIGHT_BISHOP,
+    MATERIAL_DARK_BISHOP,
+    MATERIAL_ROOK,
+    MATERIAL_QUEEN,
+    MATERIAL_NUM_KINDS
+};
+
+/* The material key of a position holds the number of pieces of each side and kind (kings aside)
+ * in a field of 4 bits, which is enough even if all the pawns of a side promote into the same
+ * kind of piece. Hence the material key identifies the material exactly, and it is updated by
+ * adding or subtracting the unit of a piece whenever the piece is added to or removed from the
+ * board.
+ *
+ * 'g_material_units' is indexed by side, piece type and square (0..63).
+ */
+extern u64 g_material_units[2][8][64];
+
+#define MATERIAL_COUNT(key, side, kind) \
+    ((int)(((key) >> (((side) * MATERIAL_NUM_KINDS + (kind)) * 4)) & 0xF))
+
+/* Adds ('sign' is +1) or removes ('sign' is -1) the piece of 'side' and 'type' on square 'sq'
+ * (0..63) to or from the material key of position 'pos'.
+ */
+#define MATERIAL_ADD_PIECE(pos, side, type, sq, sign)                                             \
+    MACRO_BEGIN                                                                                   \
+    (pos)->material_key += (u64)(sign) * g_material_units[(side)][(type)][(sq)];                  \
+    MACRO_END
+
+/* The game phase of a side ranges from 0, in the endgame, to MATERIAL_PHASE_MAX, in the
+ * middlegame, see eval().
+ */
+#define MATERIAL_PHASE_MAX 1200
+
+/* The scale factor of a side's advantage in the evaluation, if it has no reason to be scaled
+ * down.
+ */
+#define MATERIAL_SCALE_NORMAL 16
+
+/* What follows from the material alone, looked up by material_probe(). */
+typedef struct
+{
+    u64 key;
+    int phase[2];
+    /* Indexed by the side that is ahead, the part (out of MATERIAL_SCALE_NORMAL) of its advantage
+     * that counts, for endgames that are harder to win than the material suggests.
+     */
+    u8 scale[2];
+    /* Set if neither side can checkmate, see is_draw_by_insufficient_material(). */
+    u8 is_insufficient_material;
+} material_entry_t;
+
+u64 compute_material_key(const gupta_position_t *pos);
+void init_material(void);
+const material_entry_t *material_probe(const gupta_position_t *pos);
+
+#endif /* !defined(MATERIAL_H) */
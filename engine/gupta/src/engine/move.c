@@ -14,12 +14,16 @@
 #include "bitops.h"
 #include "board.h"
 #include "common.h"
+#include "compiler_specific.h"
 #include "enforce.h"
+#include "eval.h"
 #include "log.h"
+#include "material.h"
 #include "move.h"
 #include "rules.h"
 #include "search.h"
 #include "uassert.h"
+#include "zobrist.h"
 
 #include <stdlib.h>
 
@@ -30,82 +34,31 @@ typedef struct
        pawn_right;
 } en_passant_t;
 
-/* The capturing moves are stored at the beginning of the stack portion for the current game tree
- * height. The non-capturing moves are stored at the end of the stack portion for the current game
- * tree height.
- */
-size_t move_stack_current_capture_index,
-       move_stack_current_noncapture_index;
-move_t *g_move_stack = NULL;
-size_t g_move_stack_num_elements = 0;
-int using_custom_move_stack = 0;
-
-size_t    g_history_idx;
-history_t *g_history_stack = NULL;
-size_t    g_history_stack_num_elements = 0;
-
-static void ensure_move_stack_has_space(void)
-{
-    size_t search_depth,
-           num_elements_required;
-    void *p;
-
-    if (using_custom_move_stack)
-    {
-        /* The caller of switch_to_move_stack() is responsible for providing move stack memory.
-         * See switch_to_move_stack() for more information.
-         */
-        return;
-    }
-
-    search_depth = gupta_get_search_depth();
-    num_elements_required = search_depth * MOVE_STACK_MAX_MOVES_PER_HEIGHT;
-
-    if (num_elements_required == g_move_stack_num_elements)
-    {
-        /* The move stack doesn't need to be expanded or shrunk. */
-        return;
-    }
-
-    g_move_stack_num_elements = num_elements_required;
-
-    p = realloc(g_move_stack, sizeof(g_move_stack[0]) * g_move_stack_num_elements);
-    if (!p)
-    {
-        free(g_move_stack);
-        enforce(0 && "out of memory");
-    }
-
-    g_move_stack = p;
-
-    /* Make sure the post-condition is met (space must now be available). */
-    UASSERT(num_elements_required == g_move_stack_num_elements);
-}
-
-static void ensure_history_stack_has_space(void)
+static void ensure_history_stack_has_space(gupta_position_t *pos)
 {
     void *p;
 
-    if ((g_history_idx != 0) && (g_history_idx < g_history_stack_num_elements))
+    if ((pos->history_idx != 0) && (pos->history_idx < pos->history_stack_num_elements))
     {
         /* Space is still available. */
         return;
     }
 
 #define HISTORY_STACK_NUM_ELEMENTS_INITIAL 200
-    g_history_stack_num_elements = (g_history_idx ? g_history_idx * 2 : HISTORY_STACK_NUM_ELEMENTS_INITIAL);
+    pos->history_stack_num_elements = (pos->history_idx ? pos->history_idx * 2 :
+                                                          HISTORY_STACK_NUM_ELEMENTS_INITIAL);
 
-    p = realloc(g_history_stack, g_history_stack_num_elements * sizeof(*g_history_stack));
+    p = realloc(pos->history_stack, pos->history_stack_num_elements * sizeof(*pos->history_stack));
     if (!p)
     {
-        free(g_history_stack);
+        free(pos->history_stack);
         enforce(0 && "out of memory");
     }
 
-    g_history_stack = p;
+    pos->history_stack = p;
 
     /* Make sure the post-condition is met (space must now be available). */
-    UASSERT(g_history_idx < g_history_stack_num_elements);
+    UASSERT(pos->history_idx < pos->history_stack_num_elements);
 }
 
 static void construct_castling(castling_t *castling, int piece_type, u8 from, u8 to)
@@ -179,109 +132,145 @@ static void construct_en_passant(en_passant_t *en_passant, u8 en_passant_square)
     en_passant->pawn_right = en_passant_square + 0x01;
 }
 
-static void gen_push_move(u8 from, u8 to, u8 promote, int is_en_passant_move)
+/* The moves being generated by gen_moves(). */
+typedef struct
 {
-    int is_capture = 0;
-    size_t index;
+    int kinds;
+    scored_move_t *moves;
+    size_t num_moves;
+} move_list_t;
 
-    /* Stack space must be available. */
-    UASSERT(move_stack_current_capture_index < move_stack_current_noncapture_index);
+static void push_move(move_list_t *list, u8 from, u8 to, u8 promote)
+{
+    /* Space must be available. */
+    UASSERT(list->num_moves < MOVES_MAX);
 
     /* The locations must be valid. */
     UASSERT(((from & 0x88) == 0) && ((to & 0x88) == 0));
 
-    /* Generate promotion moves if necessary. */
-    if ((promote == PROMOTE_NONE) && (PIECE_TYPE(*g_board[from]) == PAWN) &&
-        (((to & 0xF0) == 0x70) || ((to & 0xF0) == 0x00)))
+    list->moves[list->num_moves++].move = PACK_MOVE(from, to, promote);
+}
+
+/* Generates the move of a pawn from 'from' to 'to', or if 'to' is on the last rank, the promotions
+ * into every piece type. Of the promotions that don't capture, only the one into a queen is a noisy
+ * move, see GEN_NOISY.
+ */
+static void push_pawn_move(move_list_t *list, u8 from, u8 to, int is_capture)
+{
+    if (((to & 0xF0) == 0x70) || ((to & 0xF0) == 0x00))
     {
-        gen_push_move(from, to, PROMOTE_QUEEN, 0);
-        gen_push_move(from, to, PROMOTE_ROOK, 0);
-        gen_push_move(from, to, PROMOTE_BISHOP, 0);
-        gen_push_move(from, to, PROMOTE_KNIGHT, 0);
-        return;
+        if (list->kinds & GEN_NOISY)
+            push_move(list, from, to, PROMOTE_QUEEN);
+        if (list->kinds & (is_capture ? GEN_NOISY : GEN_QUIET))
+        {
+            push_move(list, from, to, PROMOTE_ROOK);
+            push_move(list, from, to, PROMOTE_BISHOP);
+            push_move(list, from, to, PROMOTE_KNIGHT);
+        }
     }
+    else if (list->kinds & (is_capture ? GEN_NOISY : GEN_QUIET))
+        push_move(list, from, to, PROMOTE_NONE);
+}
 
-    if (g_board[to] || is_en_passant_move)
-        is_capture = 1;
+/* Generates a move from 'from' to every square in 'targets'. */
+static void push_moves(move_list_t *list, u8 from, u64 targets)
+{
+    for (; targets; BB_CLEAR_LSB(targets))
+        push_move(list, from, SQ88(BB_LSB(targets)), PROMOTE_NONE);
+}
 
-    if (is_capture)
-        index = move_stack_current_capture_index;
-    else
-        index = move_stack_current_noncapture_index;
+/* Adds 'piece' to, or removes it from, 'location' in the bitboards, the material key and the
+ * evaluation sums.
+ */
+static void toggle_piece(gupta_position_t *pos, s8 piece, u8 location)
+{
+    int side = PIECE_SIDE(piece),
+        type = PIECE_TYPE(piece),
+        sq = SQ64(location),
+        sign;
+    u64 bb = BB_SQUARE(sq);
+
+    pos->bitboards[side][type] ^= bb;
+    pos->bitboards[side][NOPIECE] ^= bb;
+
+    sign = (pos->bitboards[side][type] & bb) ? +1 : -1;
+    EVAL_ADD_PIECE(pos, side, type, sq, sign);
+    MATERIAL_ADD_PIECE(pos, side, type, sq, sign);
+}
 
-    g_move_stack[index].from = from;
-    g_move_stack[index].to = to;
-    g_move_stack[index].promote = promote;
+/* Returns the pieces of 'side' that are pinned to its king on 'king_sq', that is, the pieces that
+ * are the only piece between the king and an enemy slider that moves along their line.
+ */
+static u64 pinned_pieces(const gupta_position_t *pos, int side, int king_sq, u64 occupied)
+{
+    const u64 *enemy = pos->bitboards[side ^ 1];
+    u64 pinned = 0,
+        snipers = (BISHOP_ATTACKS(king_sq, 0) & (enemy[BISHOP] | enemy[QUEEN])) |
+                  (ROOK_ATTACKS(king_sq, 0) & (enemy[ROOK] | enemy[QUEEN]));
 
-    if (is_capture)
-        move_stack_current_capture_index++;
-    else
-        move_stack_current_noncapture_index--;
+    for (; snipers; BB_CLEAR_LSB(snipers))
+    {
+        u64 blockers = g_between[king_sq][BB_LSB(snipers)] & occupied;
+
+        if (blockers && !BB_HAS_MANY(blockers))
+            pinned |= blockers & pos->bitboards[side][NOPIECE];
+    }
+
+    return pinned;
 }
 
-const move_t *gupta_get_best_move()
+/* An En Passant move removes two pawns from the same rank at once, and it captures a pawn that
+ * isn't on its destination square, so the usual check and pin masks don't apply. Instead, look at
+ * whether any piece (other than the captured pawn) attacks the king after the move.
+ */
+static int is_en_passant_move_legal(const gupta_position_t *pos, int from, int to, int king_sq)
 {
-    UASSERT((g_best_move_idx != (size_t)-1) && "no move was found");
-    return &g_move_stack[g_best_move_idx];
+    u64 occupied = (OCCUPIED_SQUARES(pos) ^ BB_SQUARE(from) ^ BB_SQUARE(SQ64(pos->en_passant))) |
+                   BB_SQUARE(to);
+
+    return !(attackers_to(pos, king_sq, occupied) & pos->bitboards[pos->oside][NOPIECE] & occupied);
 }
 
-int can_make_any_move(int side)
+/* Returns whether 'm' is one of the legal moves, or if 'm' is NULL, whether there are any legal
+ * moves at all.
+ * The moves are generated into a local move list on the C stack, so that this function may be
+ * called while the engine is searching, and that positions can be used from several threads at
+ * once.
+ */
+static int find_legal_move(const gupta_position_t *pos, const move_t *m)
 {
-    int result = 0;
-    int switch_turn_back = 0;
-    size_t range_idx = 0;
-    range_t move_stack_ranges[2]; /* Ranges for capturing and non-capturing moves. */
-    static move_t l_move_stack[MOVE_STACK_MAX_MOVES_PER_HEIGHT];
-    move_stack_metadata_t move_stack_metadata;
-
-    if (g_tside != side)
-    {
-        switch_turn_back = 1;
-        switch_turn();
-        UASSERT(g_tside == side);
-    }
+    scored_move_t moves[MOVES_MAX];
 
-    /* Temporarily use our local move stack as the global move stack, so that we don't overwrite
-     * the moves generated by the search algorithm (after all, *this* function may be called while
-     * the engine is searching) when we generate moves to determine whether any move can be made.
-     */
-    switch_to_move_stack(&move_stack_metadata, l_move_stack);
+    if (m)
+        return is_legal_move(pos, PACK_MOVE_T(*m), GEN_ALL);
 
-    gen_moves(0, move_stack_ranges);
+    return gen_moves(pos, GEN_ALL, moves) > 0;
+}
 
-    for (range_idx = 0; range_idx < ARRAY_SIZE(move_stack_ranges); range_idx++)
-    {
-        size_t idx;
-        range_t *range = &move_stack_ranges[range_idx];
+int can_make_any_move(gupta_position_t *pos, int side)
+{
+    int result;
+    u8 en_passant = pos->en_passant;
 
-        for (idx = range->begin; idx < range->end; idx++)
-        {
-            if (make_move(&g_move_stack[idx], MOVE_NOSTRICT_VALIDATION))
-            {
-                gupta_undo_move();
-                result = 1;
-                goto done;
-            }
-        }
-    }
+    if (pos->tside == side)
+        return find_legal_move(pos, NULL);
+
+    /* The En Passant opportunity (if any) is only available to the side whose turn it is. */
+    switch_turn(pos);
+    pos->en_passant = 0x88;
+    result = find_legal_move(pos, NULL);
+    pos->en_passant = en_passant;
+    switch_turn(pos);
 
-done:
-    if (switch_turn_back)
-        switch_turn();
-    switch_to_move_stack_from_metadata(&move_stack_metadata);
     return result;
 }
 
-/* Parameters:
- *   game_tree_height [in]
- *     The game tree height to generate moves for. Used to calculate which portion of the move
- *     stack should be used to store the moves.
- *   ranges [in]
- *     Ranges into the move stack, for the capturing and non-capturing moves for the current game
- *     tree height. The first element is the range for capturing moves, the second element is for
- *     non-capturing moves.
+/* Generates the legal moves of the kinds 'kinds' (see GEN_NOISY) of the pieces on the squares
+ * 'sources' of the side whose turn it is, and stores them in 'moves', which must have room for
+ * MOVES_MAX moves. Returns the number of moves.
  */
-void gen_moves(size_t game_tree_height, range_t ranges[2])
+static size_t gen_moves_from(const gupta_position_t *pos, int kinds, u64 sources,
+                             scored_move_t *moves)
 {
     /* Castling sources:
      *     0x04 (white king)
@@ -305,238 +294,238 @@ void gen_moves(size_t game_tree_height, range_t ranges[2])
     u32 castling_destinations[] = {0x06050203, 0x76757273};
     u8 castling_source;
     u32 castling_destination;
-    size_t first_index,
-           last_index,
-           i;
-
-    /* Resize the move stack if necessary. Do this at this moment, not right at the moment that the
-     * search depth is changed, because the search depth may be changed while the search algorithm
-     * is running, and if the search depth was changed to a lower value, immediately resizing would
-     * be dangerous, as the moves from a higher depth may still be accessed while algorithm is
-     * descending up the tree (to reach the new search depth).
+    const u64 enemies = pos->bitboards[pos->oside][NOPIECE];
+    u64 occupied = OCCUPIED_SQUARES(pos),
+        kind_mask,
+        checkers,
+        pinned,
+        evasion_mask,
+        targets,
+        pieces;
+    int king_sq = KING_SQUARE(pos, pos->tside),
+        may_castle,
+        type;
+    move_list_t list;
+
+    list.kinds = kinds;
+    list.moves = moves;
+    list.num_moves = 0;
+
+    /* The squares that the pieces other than pawns move to, for the kinds of moves asked for. */
+    kind_mask = ((kinds & GEN_NOISY) ? enemies : 0) | ((kinds & GEN_QUIET) ? ~occupied : 0);
+
+    checkers = attackers_to(pos, king_sq, occupied) & enemies;
+
+    /* The king may go to any square that isn't attacked. The king itself mustn't block the
+     * sliders, as it would still be attacked on a square further along their line.
      */
-    ensure_move_stack_has_space();
-
-    first_index = MOVE_STACK_FIRST_INDEX_FOR_HEIGHT(game_tree_height);
-    last_index = MOVE_STACK_LAST_INDEX_FOR_HEIGHT(game_tree_height);
-    move_stack_current_capture_index = first_index;
-    move_stack_current_noncapture_index = last_index;
-
-    for (i = g_piece_ranges[g_tside].begin; i < g_piece_ranges[g_tside].end; i++)
+    if (sources & BB_SQUARE(king_sq))
     {
-        const s8 *delta;
-        u8 sq;
-        int move_delta_idx;
-
-        int piece_location = g_pieces[i].location;
-        int piece_side = PIECE_SIDE(g_pieces[i]);
-
-        /* We expect to only loop over the pieces of 'g_tside'. */
-        UASSERT(piece_side == g_tside);
-
-        if (g_pieces[i].is_captured)
-            continue;
-        else
+        targets = g_king_attacks[king_sq] & ~pos->bitboards[pos->tside][NOPIECE] & kind_mask;
+        for (; targets; BB_CLEAR_LSB(targets))
         {
-            /* We assume there is a piece on the given square if it's not captured. */
-            UASSERT(g_board[piece_location]);
+            int sq = BB_LSB(targets);
+
+            if (!(attackers_to(pos, sq, occupied ^ BB_SQUARE(king_sq)) & enemies))
+                push_move(&list, SQ88(king_sq), SQ88(sq), PROMOTE_NONE);
         }
+    }
 
-        if (PIECE_TYPE(g_pieces[i]) == PAWN)
-        {
-            /* Single-step pawn move. */
-            sq = piece_location + (g_tside == WHITE ? 0x10 : -0x10);
-            /* Verify that the pawn doesn't move off the board (shouldn't happen because promotion
-             * moves are generated).
-             */
-            UASSERT((sq & 0x88) == 0);
-            if (!g_board[sq])
-                gen_push_move(piece_location, sq, PROMOTE_NONE, 0);
+    /* In double check, only the king can move. */
+    if (BB_HAS_MANY(checkers))
+        goto done;
 
-            /* Two-step pawn move. */
-            if ((piece_location & 0xF0) == (piece_side == WHITE ? 0x10 : 0x60))
-            {
-                u8 sq_between;
+    /* When in check, the other pieces must either capture the checking piece, or move in between
+     * it and the king. A pinned piece may only move along the line of the pin.
+     */
+    evasion_mask = (checkers ? g_between[king_sq][BB_LSB(checkers)] | checkers : ~0ULL);
+    pinned = pinned_pieces(pos, pos->tside, king_sq, occupied);
 
-                sq = piece_location + (g_tside == WHITE ? 0x20 : -0x20);
-                sq_between = piece_location + (g_tside == WHITE ? 0x10 : -0x10);
+    for (pieces = pos->bitboards[pos->tside][PAWN] & sources; pieces; BB_CLEAR_LSB(pieces))
+    {
+        int sq = BB_LSB(pieces),
+            step = (pos->tside == WHITE ? 8 : -8);
+        u64 pushes = 0,
+            mask = evasion_mask;
 
-                /* Only generate a two-step pawn move if there is no piece in front of the pawn.
-                 * This is cheaper than needing the move validator to discard the invalid move.
-                 */
-                if (!g_board[sq] && !g_board[sq_between])
-                    gen_push_move(piece_location, sq, PROMOTE_NONE, 0);
-            }
+        if (pinned & BB_SQUARE(sq))
+            mask &= g_line[king_sq][sq];
 
-            /* Pawn capture to the left. */
-            sq = piece_location - (g_tside == WHITE ? -0x0F : 0x11);
-            if ((sq & 0x88) == 0)
-            {
-                if (g_board[sq] && PIECE_SIDE(*g_board[sq]) == g_oside)
-                    gen_push_move(piece_location, sq, PROMOTE_NONE, 0);
-            }
+        /* A pawn is never on the last rank (it would have been promoted), so it can always step
+         * forward if the square in front of it is empty, and then, if it's still on its starting
+         * rank, it may step forward twice.
+         */
+        if (!(occupied & BB_SQUARE(sq + step)))
+        {
+            pushes = BB_SQUARE(sq + step);
 
-            /* Pawn capture to the right. */
-            sq = piece_location - (g_tside == WHITE ? -0x11 : 0x0F);
-            if ((sq & 0x88) == 0)
+            if (((sq >> 3) == (pos->tside == WHITE ? 1 : 6)) &&
+                !(occupied & BB_SQUARE(sq + 2 * step)))
             {
-                if (g_board[sq] && PIECE_SIDE(*g_board[sq]) == g_oside)
-                    gen_push_move(piece_location, sq, PROMOTE_NONE, 0);
+                pushes |= BB_SQUARE(sq + 2 * step);
             }
+        }
 
-            continue;
+        for (targets = g_pawn_attacks[pos->tside][sq] & enemies & mask; targets;
+             BB_CLEAR_LSB(targets))
+        {
+            push_pawn_move(&list, SQ88(sq), SQ88(BB_LSB(targets)), 1);
         }
+        for (targets = pushes & mask; targets; BB_CLEAR_LSB(targets))
+            push_pawn_move(&list, SQ88(sq), SQ88(BB_LSB(targets)), 0);
+    }
 
-        move_delta_idx = PIECE_TYPE(g_pieces[i]);
+    for (type = KNIGHT; type <= QUEEN; type++)
+    {
+        if (type == KING)
+            continue;
 
-        for (delta = g_move_deltas[move_delta_idx]; *delta; delta++)
+        for (pieces = pos->bitboards[pos->tside][type] & sources; pieces; BB_CLEAR_LSB(pieces))
         {
-            sq = piece_location;
+            int sq = BB_LSB(pieces);
 
-            for (;;)
-            {
-                sq += *delta;
-                if (sq & 0x88)
-                {
-                    /* Square is off the board, done generating moves for this move delta. */
-                    break;
-                }
-
-                /* If there's a friendly piece on the given square, all further moves in this
-                 * direction (including the current move) are invalid.
-                 */
-                if (g_board[sq] && PIECE_SIDE(*g_board[sq]) == g_tside)
-                    break;
-
-                gen_push_move(piece_location, sq, PROMOTE_NONE, 0);
-
-                /* For the king/knight, generate at most one move in each direction. */
-                if (PIECE_TYPE(g_pieces[i]) == KING || PIECE_TYPE(g_pieces[i]) == KNIGHT)
-                    break;
-
-                /* If there was an opponent piece at the given square, all further moves in this
-                 * direction are invalid.
-                 */
-                if (g_board[sq] && PIECE_SIDE(*g_board[sq]) == g_oside)
-                    break;
-            }
+            targets = piece_attacks(type, sq, occupied) & kind_mask & evasion_mask;
+            if (pinned & BB_SQUARE(sq))
+                targets &= g_line[king_sq][sq];
+
+            push_moves(&list, SQ88(sq), targets);
         }
     }
 
-    /* For every available castling move, generate a castling move, but don't do extensive rule
-     * checking.
+    /* For every available castling move, generate a castling move. The king may not castle out
+     * of, through, or into check, and the squares between the king and the rook must be empty.
+     * Castling moves are quiet moves of the king.
      */
-    castling_source = castling_sources[g_tside] >> 16;
-    castling_destination = castling_destinations[g_tside];
+    may_castle = (kinds & GEN_QUIET) && (sources & BB_SQUARE(king_sq)) && !checkers;
+    castling_source = castling_sources[pos->tside] >> 16;
+    castling_destination = castling_destinations[pos->tside];
     /* Kingside castling move. */
-    if (BITS_ARE_ALL_CLEAR(g_castling, g_castling_masks[g_tside][0]))
+    if (may_castle && BITS_ARE_ALL_CLEAR(pos->castling, g_castling_masks[pos->tside][0]))
     {
-        const piece_t *rook = g_board[(castling_sources[g_tside] >> 8) & 0xFF];
-        UASSERT(rook && "castling bits indicate that we can castle kingside, but there's no kingside rook");
+        u8 king_to = castling_destination >> 24,
+           rook_to = (castling_destination >> 16) & 0xFF;
 
-        /* If the castling rook is not captured, it should be available for castling as it hasn't
-         * yet moved.
-         */
-        if (!rook->is_captured)
+        UASSERT((pos->board[(castling_sources[pos->tside] >> 8) & 0xFF] ==
+                 MAKE_PIECE(pos->tside, ROOK)) &&
+                "castling bits indicate that we can castle kingside, but there's no such rook");
+
+        if (!pos->board[king_to] && !pos->board[rook_to] &&
+            !(attackers_to(pos, SQ64(rook_to), occupied) & enemies) &&
+            !(attackers_to(pos, SQ64(king_to), occupied) & enemies))
         {
-            if (!g_board[castling_destination >> 24] &&
-                !g_board[(castling_destination >> 16) & 0xFF])
-            {
-                gen_push_move(castling_source, castling_destination >> 24, PROMOTE_NONE, 0);
-            }
+            push_move(&list, castling_source, king_to, PROMOTE_NONE);
         }
     }
     /* Queenside castling move. */
-    if (BITS_ARE_ALL_CLEAR(g_castling, g_castling_masks[g_tside][1]))
+    if (may_castle && BITS_ARE_ALL_CLEAR(pos->castling, g_castling_masks[pos->tside][1]))
     {
-        const piece_t *rook = g_board[castling_sources[g_tside] & 0xFF];
-        UASSERT(rook && "castling bits indicate that we can castle queenside, but there's no queenside rook");
+        u8 king_to = (castling_destination >> 8) & 0xFF,
+           rook_to = castling_destination & 0xFF,
+           rook_from = castling_sources[pos->tside] & 0xFF;
 
-        /* If the castling rook is not captured, it should be available for castling as it hasn't
-         * yet moved.
-         */
-        if (!rook->is_captured)
+        UASSERT((pos->board[rook_from] == MAKE_PIECE(pos->tside, ROOK)) &&
+                "castling bits indicate that we can castle queenside, but there's no such rook");
+
+        /* The rook passes one more square than the king does. */
+        if (!pos->board[king_to] && !pos->board[rook_to] && !pos->board[rook_from + 1] &&
+            !(attackers_to(pos, SQ64(rook_to), occupied) & enemies) &&
+            !(attackers_to(pos, SQ64(king_to), occupied) & enemies))
         {
-            if (!g_board[(castling_destination >> 8) & 0xFF] &&
-                !g_board[castling_destination & 0xFF])
-            {
-                gen_push_move(castling_source, (castling_destination >> 8) & 0xFF, PROMOTE_NONE, 0);
-            }
+            push_move(&list, castling_source, king_to, PROMOTE_NONE);
         }
     }
 
-    /* Generate En Passant moves. */
-    if (g_en_passant != 0x88)
+    /* Generate En Passant moves. The pawns that can capture the pawn that just made a two-step
+     * move are those that a pawn of the other side would attack from the En Passant destination.
+     */
+    if ((kinds & GEN_NOISY) && (pos->en_passant != 0x88))
     {
         en_passant_t en_passant;
+        int destination;
 
-        construct_en_passant(&en_passant, g_en_passant);
+        construct_en_passant(&en_passant, pos->en_passant);
+        destination = SQ64(en_passant.destination);
 
-        if ((en_passant.pawn_left & 0x88) == 0)
+        pieces = g_pawn_attacks[pos->oside][destination] & pos->bitboards[pos->tside][PAWN] &
+                 sources;
+        for (; pieces; BB_CLEAR_LSB(pieces))
         {
-            const piece_t *p = g_board[en_passant.pawn_left];
-            if (p && (PIECE_TYPE(*p) == PAWN) && (PIECE_SIDE(*p) == g_tside))
-            {
-                /* If the square to the left is valid and contains a pawn of the side whose turn it
-                 * is, generate an En Passant move for that pawn.
-                 */
-                gen_push_move(en_passant.pawn_left, en_passant.destination, PROMOTE_NONE, 1);
-            }
+            if (is_en_passant_move_legal(pos, BB_LSB(pieces), destination, king_sq))
+                push_move(&list, SQ88(BB_LSB(pieces)), en_passant.destination, PROMOTE_NONE);
         }
+    }
 
-        if ((en_passant.pawn_right & 0x88) == 0)
-        {
-            const piece_t *p = g_board[en_passant.pawn_right];
-            if (p && (PIECE_TYPE(*p) == PAWN) && (PIECE_SIDE(*p) == g_tside))
-            {
-                /* If the square to the right is valid and contains a pawn of the side whose turn
-                 * it is, generate an En Passant move for that pawn.
-                 */
-                gen_push_move(en_passant.pawn_right, en_passant.destination, PROMOTE_NONE, 1);
-            }
-        }
+done:
+    return list.num_moves;
+}
+
+/* Generates the legal moves of the kinds 'kinds' (see GEN_NOISY) of the side whose turn it is, and
+ * stores them in 'moves', which must have room for MOVES_MAX moves. Returns the number of moves.
+ * The scores of the moves are left for the caller to fill in.
+ */
+size_t gen_moves(const gupta_position_t *pos, int kinds, scored_move_t *moves)
+{
+    return gen_moves_from(pos, kinds, ~0ULL, moves);
+}
+
+/* Returns whether 'pm' is one of the legal moves of the kinds 'kinds', such as a move that the
+ * search remembered from another position. Only the moves of the piece that 'pm' moves are
+ * generated.
+ */
+int is_legal_move(const gupta_position_t *pos, packed_move_t pm, int kinds)
+{
+    scored_move_t moves[MOVES_MAX];
+    u8 from = PACKED_MOVE_FROM(pm);
+    size_t num_moves,
+           i;
+
+    if ((from & 0x88) || !pos->board[from] || (PIECE_SIDE(pos->board[from]) != pos->tside))
+        return 0;
+
+    num_moves = gen_moves_from(pos, kinds, BB_SQUARE(SQ64(from)), moves);
+    for (i = 0; i < num_moves; i++)
+    {
+        if (moves[i].move == pm)
+            return 1;
     }
 
-    ranges[0].begin = first_index;
-    /* One past the element that should be accessed. */
-    ranges[0].end = move_stack_current_capture_index;
-    ranges[1].begin = move_stack_current_noncapture_index + 1;
-    /* One past the element that should be accessed. */
-    ranges[1].end = last_index + 1;
+    return 0;
 }
 
-int make_move(const move_t *m, int strict)
+/* Makes the move 'm', which must be one of the moves generated by gen_moves() for the current
+ * position, unless 'strict' is MOVE_STRICT_VALIDATION, in which case any move is first validated.
+ * Returns 1 if the move was made, or 0 if it was invalid.
+ */
+int make_move(gupta_position_t *pos, const move_t *m, int strict)
 {
-    piece_t *piece,
-            *captured_piece;
+    s8 piece,
+       moved_piece,
+       captured_piece;
     int piece_side,
         piece_type;
-    u8 captured_piece_square;
+    u8 captured_piece_square,
+       old_castling = pos->castling,
+       old_en_passant = pos->en_passant;
     castling_t castling;
 
-    /* TODO XXX _fully_ validate the move when strict == MOVE_STRICT_VALIDATION
-     *          We only have to do this in that case, because the type of invalid moves generated
-     *          by the engine are filtered out by was_valid_move(), but user moves aren't, since
-     *          the was_valid_move() check doesn't fully validate (and it shouldn't, for
-     *          performance reasons, since it's the validation function called during the search
-     *          algorithm).
-     *          > So, make a separate function to validate the user's moves.
-     *          >> Some things we strictly have to validate are:
-     *             - When a pawn is promoted, the 'promote' member of the move structure should be
-     *               set. If it isn't, the move is invalid, as the user MUST specify what piece the
-     *               pawn should promote into.
+    /* Moves from elsewhere (such as the user's moves) must be one of the legal moves. Note that
+     * this also requires the 'promote' member of a promotion move to be set, as the user MUST
+     * specify what piece the pawn should promote into.
      */
-    (void)strict;
-
-    if ((m->from & 0x88) || (m->to & 0x88) || !g_board[m->from] ||
-        (g_board[m->to] && (PIECE_SIDE(*g_board[m->to]) == g_tside)))
-    {
+    if ((strict == MOVE_STRICT_VALIDATION) && !find_legal_move(pos, m))
         return 0;
-    }
 
-    piece = g_board[m->from];
-    piece_side = PIECE_SIDE(*piece);
-    piece_type = PIECE_TYPE(*piece);
+    piece = pos->board[m->from];
+    piece_side = PIECE_SIDE(piece);
+    piece_type = PIECE_TYPE(piece);
+
+    UASSERT(piece && (piece_side == pos->tside));
+    UASSERT(!pos->board[m->to] || (PIECE_SIDE(pos->board[m->to]) != pos->tside));
+
+    construct_castling(&castling, piece_type, m->from, m->to);
+    UASSERT(!castling.is_castling ||
+            ((pos->board[castling.rook_from] == MAKE_PIECE(piece_side, ROOK)) &&
+             !pos->board[castling.rook_to]));
 
     /* First, assume that the captured piece (if any) is on the destination square of the move. If
      * this doesn't turn out to be the case (such as with En Passant moves), then adjust it later.
@@ -546,89 +535,81 @@ int make_move(const move_t *m, int strict)
     /* First check for En Passant moves, as the piece that is captured with such moves isn't on the
      * destination square of the move.
      */
-    if ((piece_type == PAWN) && (g_en_passant != 0x88))
+    if ((piece_type == PAWN) && (pos->en_passant != 0x88))
     {
         en_passant_t en_passant;
 
-        UASSERT((g_en_passant & 0x88) == 0);
+        UASSERT((pos->en_passant & 0x88) == 0);
 
-        construct_en_passant(&en_passant, g_en_passant);
+        construct_en_passant(&en_passant, pos->en_passant);
 
         if (((m->from == en_passant.pawn_left) || (m->from == en_passant.pawn_right)) &&
             (m->to == en_passant.destination))
         {
             /* This is an En Passant move. */
-            captured_piece_square = g_en_passant;
+            captured_piece_square = pos->en_passant;
         }
     }
 
-    captured_piece = g_board[captured_piece_square];
-    if (captured_piece)
-        captured_piece->is_captured = 1;
+    captured_piece = pos->board[captured_piece_square];
 
-    ensure_history_stack_has_space();
-    g_history_stack[g_history_idx].m              = *m;
-    g_history_stack[g_history_idx].captured_piece = captured_piece;
-    g_history_stack[g_history_idx].castling       = g_castling;
-    g_history_stack[g_history_idx].en_passant     = g_en_passant;
-    g_history_idx++;
+    ensure_history_stack_has_space(pos);
+    pos->history_stack[pos->history_idx].m              = *m;
+    pos->history_stack[pos->history_idx].captured_piece = captured_piece;
+    pos->history_stack[pos->history_idx].castling       = pos->castling;
+    pos->history_stack[pos->history_idx].en_passant     = pos->en_passant;
+    pos->history_stack[pos->history_idx].halfmove_clock = pos->halfmove_clock;
+    pos->history_stack[pos->history_idx].hash_key       = pos->hash_key;
+    pos->history_idx++;
+
+    /* Promotion moves transform the pawn into the promotion piece. */
+    if (m->promote != PROMOTE_NONE)
+    {
+        UASSERT((piece_type == PAWN) && (((m->to & 0xF0) == 0x70) || ((m->to & 0xF0) == 0x00)));
+        moved_piece = MAKE_PIECE(piece_side, m->promote);
+    }
+    else
+        moved_piece = piece;
+
+    if (captured_piece)
+    {
+        toggle_piece(pos, captured_piece, captured_piece_square);
+        pos->hash_key ^= ZOBRIST_PIECE(PIECE_SIDE(captured_piece), PIECE_TYPE(captured_piece),
+                                    captured_piece_square);
+    }
 
-    g_board[m->from] = NULL;
+    pos->board[m->from] = NOPIECE;
     /* First update the captured piece square. Even though usually
      * 'captured_piece_square == m->to' is true, for En Passant moves it is not.
      */
-    g_board[captured_piece_square] = NULL;
-    g_board[m->to] = piece;
-    piece->location = m->to;
+    pos->board[captured_piece_square] = NOPIECE;
+    pos->board[m->to] = moved_piece;
+
+    toggle_piece(pos, piece, m->from);
+    toggle_piece(pos, moved_piece, m->to);
+    pos->hash_key ^= ZOBRIST_PIECE(piece_side, piece_type, m->from);
+    pos->hash_key ^= ZOBRIST_PIECE(piece_side, PIECE_TYPE(moved_piece), m->to);
 
-    /* Check for castling moves. */
-    construct_castling(&castling, piece_type, m->from, m->to);
     if (castling.is_castling)
     {
         /* The king was already moved by doing the castling move (partly), so now move the rook as
          * well.
          */
+        pos->board[castling.rook_to] = pos->board[castling.rook_from];
+        pos->board[castling.rook_from] = NOPIECE;
 
-        if (!g_board[castling.rook_from])
-        {
-            /* TODO XXX remove the do_log() call at some point */
-            do_log("Tried to castle but there was no rook at 'castling.rook_from'.\n");
-            return 0;
-        }
-        if (g_board[castling.rook_to])
-        {
-            /* TODO XXX remove the do_log() call at some point */
-            do_log("Tried to castle but there's a piece at 'castling.rook_to'.\n");
-            return 0;
-        }
-
-        g_board[castling.rook_from]->location = castling.rook_to;
-        g_board[castling.rook_to] = g_board[castling.rook_from];
-        g_board[castling.rook_from] = NULL;
+        toggle_piece(pos, pos->board[castling.rook_to], castling.rook_from);
+        toggle_piece(pos, pos->board[castling.rook_to], castling.rook_to);
+        pos->hash_key ^= ZOBRIST_PIECE(piece_side, ROOK, castling.rook_from);
+        pos->hash_key ^= ZOBRIST_PIECE(piece_side, ROOK, castling.rook_to);
 
-        g_castle_booleans[piece_side] = 1;
+        pos->castle_booleans[piece_side] = 1;
     }
 
-    /* Check for promotion moves. */
-    if (m->promote != PROMOTE_NONE)
-    {
-        UASSERT((piece_type == PAWN) && (((m->to & 0xF0) == 0x70) || ((m->to & 0xF0) == 0x00)));
+    switch_turn(pos);
+    pos->hash_key ^= g_zobrist_side;
 
-        /* Transform the pawn into the promotion piece. */
-        piece->_type = (piece_side == WHITE ? m->promote : -m->promote);
-    }
-
-    switch_turn();
-
-    /* If the move was invalid, reverse it, and return failure. */
-    if (!was_move_valid(m, &castling))
-    {
-        gupta_undo_move();
-        return 0;
-    }
-
-    /* Move was valid, only now we can update the castling bits, as the old value was used by
-     * was_valid_move().
+    /* Update the castling bits.
      * Note that if we were performing a castling move, we only set the king's 'has moved' bit, not
      * the rook's 'has moved' bit, but this is no problem, as one can't perform a castling move
      * after the king has moved.
@@ -636,25 +617,25 @@ int make_move(const move_t *m, int strict)
     if (piece_type == KING)
     {
         if (piece_side == WHITE)
-            g_castling |= WHITE_KING_IS_NOT_AVAILABLE;
+            pos->castling |= WHITE_KING_IS_NOT_AVAILABLE;
         else
-            g_castling |= BLACK_KING_IS_NOT_AVAILABLE;
+            pos->castling |= BLACK_KING_IS_NOT_AVAILABLE;
     }
     else if (piece_type == ROOK)
     {
         if (piece_side == WHITE)
         {
             if (m->from == 0x07)
-                g_castling |= WHITE_KINGS_ROOK_IS_NOT_AVAILABLE;
+                pos->castling |= WHITE_KINGS_ROOK_IS_NOT_AVAILABLE;
             else if (m->from == 0x00)
-                g_castling |= WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE;
+                pos->castling |= WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE;
         }
         else
         {
             if (m->from == 0x77)
-                g_castling |= BLACK_KINGS_ROOK_IS_NOT_AVAILABLE;
+                pos->castling |= BLACK_KINGS_ROOK_IS_NOT_AVAILABLE;
             else if (m->from == 0x70)
-                g_castling |= BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE;
+                pos->castling |= BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE;
         }
     }
 
@@ -668,41 +649,28 @@ int make_move(const move_t *m, int strict)
      */
     if (captured_piece)
     {
-        int update_castling_flags = 0,
-            kingside_rook = 0 /* Initialize to prevent erroneous compiler warning. */;
-
-        if ((captured_piece->location == 0x77) || (captured_piece->location == 0x07))
-        {
-            kingside_rook = 1;
-            update_castling_flags = 1;
-        }
-        else if ((captured_piece->location == 0x70) || (captured_piece->location == 0x00))
-        {
-            kingside_rook = 0;
-            update_castling_flags = 1;
-        }
-
-        if (update_castling_flags)
-        {
-            if (kingside_rook)
-            {
-                if (piece_side == WHITE)
-                    g_castling |= BLACK_KINGS_ROOK_IS_NOT_AVAILABLE;
-                else
-                    g_castling |= WHITE_KINGS_ROOK_IS_NOT_AVAILABLE;
-            }
-            else
-            {
-                if (piece_side == WHITE)
-                    g_castling |= BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE;
-                else
-                    g_castling |= WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE;
-            }
-        }
+        /* The square decides whose castling availability is lost, not the side that captured.
+         * If the captured piece isn't the rook of the side the square belongs to (it may be a
+         * piece that a pawn promoted into on that square, for example), that rook already left.
+         */
+        if (captured_piece_square == 0x07)
+            pos->castling |= WHITE_KINGS_ROOK_IS_NOT_AVAILABLE;
+        else if (captured_piece_square == 0x00)
+            pos->castling |= WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE;
+        else if (captured_piece_square == 0x77)
+            pos->castling |= BLACK_KINGS_ROOK_IS_NOT_AVAILABLE;
+        else if (captured_piece_square == 0x70)
+            pos->castling |= BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE;
     }
 
+    /* Captures and pawn moves can't be undone, so they restart the count of the fifty-move rule. */
+    if (captured_piece || (piece_type == PAWN))
+        pos->halfmove_clock = 0;
+    else
+        pos->halfmove_clock++;
+
     /* Check for En Passant opportunities. */
-    g_en_passant = 0x88; /* Until proven otherwise, assume there is no En Passant opportunity. */
+    pos->en_passant = 0x88; /* Until proven otherwise, assume there is no En Passant opportunity. */
     if (piece_type == PAWN)
     {
         if (abs(m->to - m->from) == 0x20)
@@ -710,69 +678,84 @@ int make_move(const move_t *m, int strict)
             /* An En Passant opportunity was created. Save the location of the square containing
              * the pawn that can be captured by an En Passant move.
              */
-            g_en_passant = m->to;
+            pos->en_passant = m->to;
         }
     }
 
+    if (pos->castling != old_castling)
+        pos->hash_key ^= zobrist_castling_key(old_castling) ^ zobrist_castling_key(pos->castling);
+    if (pos->en_passant != old_en_passant)
+    {
+        pos->hash_key ^= zobrist_en_passant_key(old_en_passant) ^
+                         zobrist_en_passant_key(pos->en_passant);
+    }
+
     return 1;
 }
 
-/* Switches to a custom move stack. The caller is responsible for providing memory in the move
- * stack so that gen_moves() doesn't write outside its bounds. This can easily be achieved by
- * using the MOVE_STACK_MAX_MOVES_PER_HEIGHT constant.
- * We could also choose instead, to pass move stack metadata to gen_push_move() every time it is
- * called in gen_moves(), so that one can pass metadata to gen_moves() which is then passed to
- * gen_push_move(). However, the alternative, saving metadata and restoring it later, isn't bad
- * either, and it's more efficient.
+/* A null move passes the turn to the other side without moving a piece (see search()). It is
+ * recorded in the history as a move from and to the invalid location 0x88.
  */
-void switch_to_move_stack(move_stack_metadata_t *metadata, move_t *move_stack)
+void make_null_move(gupta_position_t *pos)
 {
-    metadata->current_capture_index    = move_stack_current_capture_index;
-    metadata->current_noncapture_index = move_stack_current_noncapture_index;
-    metadata->move_stack               = g_move_stack;
-    metadata->num_elements             = g_move_stack_num_elements;
-
-    g_move_stack = move_stack;
-
-    using_custom_move_stack = 1;
+    ensure_history_stack_has_space(pos);
+    pos->history_stack[pos->history_idx].m.from         = 0x88;
+    pos->history_stack[pos->history_idx].m.to           = 0x88;
+    pos->history_stack[pos->history_idx].m.promote      = PROMOTE_NONE;
+    pos->history_stack[pos->history_idx].captured_piece = NOPIECE;
+    pos->history_stack[pos->history_idx].castling       = pos->castling;
+    pos->history_stack[pos->history_idx].en_passant     = pos->en_passant;
+    pos->history_stack[pos->history_idx].halfmove_clock = pos->halfmove_clock;
+    pos->history_stack[pos->history_idx].hash_key       = pos->hash_key;
+    pos->history_idx++;
+
+    pos->hash_key ^= zobrist_en_passant_key(pos->en_passant) ^ g_zobrist_side;
+    pos->en_passant = 0x88;
+    pos->halfmove_clock = 0;
+
+    switch_turn(pos);
 }
 
-void switch_to_move_stack_from_metadata(const move_stack_metadata_t *metadata)
-{
-    move_stack_current_capture_index    = metadata->current_capture_index;
-    move_stack_current_noncapture_index = metadata->current_noncapture_index;
-    g_move_stack                        = metadata->move_stack;
-    g_move_stack_num_elements           = metadata->num_elements;
-
-    using_custom_move_stack = 0;
-}
-
-int gupta_make_move(const move_t *m)
+int gupta_make_move(gupta_position_t *pos, const move_t *m)
 {
     int r;
 
-    if (g_result != GUPTA_RESULT_NONE)
+    if (pos->result != GUPTA_RESULT_NONE)
     {
-        UASSERT(0 && "gupta_make_move() called but the game was already over.");
+        UASSERT(0 && "gupta_make_move(pos) called but the game was already over.");
         return 0;
     }
 
-    r = make_move(m, MOVE_STRICT_VALIDATION);
+    r = make_move(pos, m, MOVE_STRICT_VALIDATION);
     if (r)
     {
         /* We don't care whether the game is over or not, we just want to store the result (if any)
-         * in the global result variable.
+         * in the position.
          */
-        (void)gupta_is_game_over(&g_result);
+        (void)gupta_is_game_over(pos, &pos->result);
     }
 
     return r;
 }
 
-void gupta_undo_move()
+void undo_null_move(gupta_position_t *pos)
 {
-    piece_t *piece,
-            *captured_piece;
+    UASSERT((pos->history_idx > 0) && (pos->history_stack[pos->history_idx - 1].m.from == 0x88));
+
+    --pos->history_idx;
+
+    pos->en_passant = pos->history_stack[pos->history_idx].en_passant;
+    pos->halfmove_clock = pos->history_stack[pos->history_idx].halfmove_clock;
+    pos->hash_key = pos->history_stack[pos->history_idx].hash_key;
+
+    switch_turn(pos);
+}
+
+void gupta_undo_move(gupta_position_t *pos)
+{
+    s8 piece,
+       moved_piece,
+       captured_piece;
     const move_t *m;
     castling_t castling;
     int piece_side,
@@ -780,37 +763,31 @@ void gupta_undo_move()
     u8 captured_piece_square,
        en_passant_square;
 
-    if (g_history_idx < 1)
+    if (pos->history_idx < 1)
         return;
 
-    --g_history_idx;
+    --pos->history_idx;
 
     /* If we can and do indeed undo a move, the game is not over yet. */
-    g_result = GUPTA_RESULT_NONE;
+    pos->result = GUPTA_RESULT_NONE;
 
-    m = &g_history_stack[g_history_idx].m;
+    m = &pos->history_stack[pos->history_idx].m;
 
-    piece = g_board[m->to];
-    piece_type = PIECE_TYPE(*piece);
-    piece_side = PIECE_SIDE(*piece);
+    moved_piece = pos->board[m->to];
+    piece_side = PIECE_SIDE(moved_piece);
 
-    piece->location = m->from;
-    if (m->promote != PROMOTE_NONE)
-    {
-        /* Transform the promotion piece back into a pawn. */
-        piece->_type = (piece_side == WHITE ? PAWN : -PAWN);
-    }
+    /* Transform a promotion piece back into a pawn. */
+    piece = (m->promote != PROMOTE_NONE ? MAKE_PIECE(piece_side, PAWN) : moved_piece);
+    piece_type = PIECE_TYPE(piece);
 
-    captured_piece = g_history_stack[g_history_idx].captured_piece;
-    if (captured_piece)
-        captured_piece->is_captured = 0;
+    captured_piece = pos->history_stack[pos->history_idx].captured_piece;
 
     /* First, assume that the captured piece (if any) was on the destination square of the move. If
      * this doesn't turn out to be the case (such as with En Passant moves), then adjust it later.
      */
     captured_piece_square = m->to;
 
-    en_passant_square = g_history_stack[g_history_idx].en_passant;
+    en_passant_square = pos->history_stack[pos->history_idx].en_passant;
 
     /* First check for En Passant moves, as the piece that is captured with such moves isn't on the
      * destination square of the move.
@@ -831,43 +808,64 @@ void gupta_undo_move()
         }
     }
 
-    g_board[m->from] = piece;
+    pos->board[m->from] = piece;
     /* First update the move destination square. Even though usually
      * 'captured_piece_square == m->to' is true, for En Passant moves it is not.
      */
-    g_board[m->to] = NULL;
-    g_board[captured_piece_square] = captured_piece;
+    pos->board[m->to] = NOPIECE;
+    pos->board[captured_piece_square] = captured_piece;
+
+    toggle_piece(pos, moved_piece, m->to);
+    toggle_piece(pos, piece, m->from);
+    if (captured_piece)
+        toggle_piece(pos, captured_piece, captured_piece_square);
 
     /* Check for castling moves. */
-    construct_castling(&castling, PIECE_TYPE(*piece), m->from, m->to);
+    construct_castling(&castling, piece_type, m->from, m->to);
     if (castling.is_castling)
     {
         /* The king was already moved by undoing the castling move (partly), so now move the rook
          * as well.
          */
 
-        UASSERT(g_board[castling.rook_to]);
-        UASSERT(!g_board[castling.rook_from]);
+        UASSERT(pos->board[castling.rook_to]);
+        UASSERT(!pos->board[castling.rook_from]);
+
+        pos->board[castling.rook_from] = pos->board[castling.rook_to];
+        pos->board[castling.rook_to] = NOPIECE;
 
-        g_board[castling.rook_to]->location = castling.rook_from;
-        g_board[castling.rook_from] = g_board[castling.rook_to];
-        g_board[castling.rook_to] = NULL;
+        toggle_piece(pos, pos->board[castling.rook_from], castling.rook_to);
+        toggle_piece(pos, pos->board[castling.rook_from], castling.rook_from);
 
-        g_castle_booleans[piece_side] = 0;
+        pos->castle_booleans[piece_side] = 0;
     }
 
-    g_castling = g_history_stack[g_history_idx].castling;
+    pos->castling = pos->history_stack[pos->history_idx].castling;
+
+    pos->en_passant = en_passant_square;
 
-    g_en_passant = en_passant_square;
+    pos->halfmove_clock = pos->history_stack[pos->history_idx].halfmove_clock;
 
-    switch_turn();
+    pos->hash_key = pos->history_stack[pos->history_idx].hash_key;
+
+    switch_turn(pos);
+}
+
+/* Returns the number of moves made since the game was started or the board was set up, which is
+ * also the number of moves that can be undone.
+ */
+size_t gupta_get_num_moves_made(const gupta_position_t *pos)
+{
+    return pos->history_idx;
 }
 
-/* Convert a move to Coordinate Algebraic Notation (CAN). */
+/* Convert a move to Coordinate Algebraic Notation (CAN). The returned string stays valid until the
+ * next call by the same thread.
+ */
 const char *gupta_move_to_can(const move_t *m)
 {
 #define CAN_MOVE_BUF_SIZE 6
-    static char move_buf[CAN_MOVE_BUF_SIZE];
+    static THREAD_LOCAL char move_buf[CAN_MOVE_BUF_SIZE];
     int i = 0;
 
     if ((m->from & 0x88) || (m->to & 0x88))
@@ -14,15 +14,20 @@
 #ifndef MOVE_H
 #define MOVE_H
 
+#include "board_public.h"
+#include "compiler_specific.h"
 #include "move_public.h"
-#include "move_deltas.h"
 #include "piece.h"
+#include "types.h"
 
 #include <stddef.h>
 
 #define MOVE_NOSTRICT_VALIDATION 0
 #define MOVE_STRICT_VALIDATION 1
 
+#define MOVES_ARE_EQUAL(a, b) (((a).from == (b).from) && ((a).to == (b).to) &&                   \
+                               ((a).promote == (b).promote))
+
 typedef struct
 {
     int is_castling,
@@ -33,34 +38,60 @@ typedef struct
 
 typedef struct
 {
-    move_t  m;
-    piece_t *captured_piece;
-    u8      castling;
-    u8      en_passant;
+    move_t m;
+    s8     captured_piece;
+    u8     castling;
+    u8     en_passant;
+    int    halfmove_clock;
+    u64    hash_key; /* The hash key of the position before the move was made. */
 } history_t;
 
+/* The move generator packs a move into a single integer: the 0x88 locations 'from' and 'to' in
+ * bits 0-7 and 8-15, and the piece type that a pawn promotes into (or PROMOTE_NONE) in the bits
+ * above them. Moves are then compared, copied and stored next to their scores at little cost.
+ * PACKED_MOVE_NONE denotes no move, as no move goes from a square to the same square.
+ */
+typedef u32 packed_move_t;
+
+#define PACKED_MOVE_NONE 0
+
+#define PACK_MOVE(from, to, promote)                                                              \
+    ((packed_move_t)(from) | ((packed_move_t)(to) << 8) | ((packed_move_t)(promote) << 16))
+#define PACKED_MOVE_FROM(pm)    ((u8)((pm) & 0xFF))
+#define PACKED_MOVE_TO(pm)      ((u8)(((pm) >> 8) & 0xFF))
+#define PACKED_MOVE_PROMOTE(pm) ((u8)((pm) >> 16))
+
+#define PACK_MOVE_T(m) PACK_MOVE((m).from, (m).to, (m).promote)
+#define UNPACK_MOVE(m, pm)                                                                        \
+    MACRO_BEGIN                                                                                   \
+    (m).from = PACKED_MOVE_FROM(pm);                                                              \
+    (m).to = PACKED_MOVE_TO(pm);                                                                  \
+    (m).promote = PACKED_MOVE_PROMOTE(pm);                                                        \
+    MACRO_END
+
+/* A generated move, and the score that the search orders it by. */
 typedef struct
 {
-    size_t current_capture_index,
-           current_noncapture_index;
-    move_t *move_stack;
-    size_t num_elements;
-} move_stack_metadata_t;
-
-#define MOVE_STACK_MAX_MOVES_PER_HEIGHT      323 /* See 'doc/move_stack_size.txt'. */
-#define MOVE_STACK_FIRST_INDEX_FOR_HEIGHT(n) ((n) * MOVE_STACK_MAX_MOVES_PER_HEIGHT)
-#define MOVE_STACK_LAST_INDEX_FOR_HEIGHT(n)  (((n)+1) * MOVE_STACK_MAX_MOVES_PER_HEIGHT - 1)
-extern move_t *g_move_stack;
-extern size_t g_move_stack_num_elements;
-
-extern size_t    g_history_idx;
-extern history_t *g_history_stack;
-extern size_t    g_history_stack_num_elements;
-
-int can_make_any_move(int side);
-void gen_moves(size_t game_tree_height, range_t ranges[2]);
-int make_move(const move_t *m, int strict);
-void switch_to_move_stack(move_stack_metadata_t *metadata, move_t *move_stack);
-void switch_to_move_stack_from_metadata(const move_stack_metadata_t *metadata);
+    packed_move_t move;
+    int score;
+} scored_move_t;
+
+/* The most moves that gen_moves() can generate for a position, see 'doc/move_list_size.txt'. */
+#define MOVES_MAX 323
+
+/* The kinds of moves that gen_moves() generates. The noisy moves are the captures (En Passant
+ * included) and the promotions to a queen, which the quiescence search looks at. The quiet moves
+ * are all the other moves.
+ */
+#define GEN_NOISY (1 << 0)
+#define GEN_QUIET (1 << 1)
+#define GEN_ALL   (GEN_NOISY | GEN_QUIET)
+
+int can_make_any_move(gupta_position_t *pos, int side);
+size_t gen_moves(const gupta_position_t *pos, int kinds, scored_move_t *moves);
+int is_legal_move(const gupta_position_t *pos, packed_move_t pm, int kinds);
+int make_move(gupta_position_t *pos, const move_t *m, int strict);
+void make_null_move(gupta_position_t *pos);
+void undo_null_move(gupta_position_t *pos);
 
 #endif /* !defined(MOVE_H) */
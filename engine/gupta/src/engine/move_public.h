@@ -14,9 +14,12 @@
 #ifndef MOVE_PUBLIC_H
 #define MOVE_PUBLIC_H
 
+#include "board_public.h"
 #include "piece_public.h"
 #include "types.h"
 
+#include <stddef.h>
+
 #define PROMOTE_NONE   0
 #define PROMOTE_QUEEN  QUEEN
 #define PROMOTE_ROOK   ROOK
@@ -30,9 +33,9 @@ typedef struct
        promote;
 } move_t;
 
-const move_t *gupta_get_best_move(void);
-int gupta_make_move(const move_t *m);
+size_t gupta_get_num_moves_made(const gupta_position_t *pos);
+int gupta_make_move(gupta_position_t *pos, const move_t *m);
 const char *gupta_move_to_can(const move_t *m);
-void gupta_undo_move(void);
+void gupta_undo_move(gupta_position_t *pos);
 
 #endif /* !defined(MOVE_PUBLIC_H) */
@@ -0,0 +1,186 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#include "perft_public.h"
+#include "board.h"
+#include "common.h"
+#include "move.h"
+#include "search_public.h"
+#include "timer.h"
+#include "uassert.h"
+
+#include <stdio.h>
+
+typedef struct
+{
+    const char *fen;
+    size_t default_depth;
+
+    /* Expected node counts for depths 1 and up, until the first 0. */
+    u64 nodes[6];
+} perft_position_t;
+
+/* Well-known positions, which together cover castling, En Passant captures (including ones that
+ * would expose the king), promotions and checks.
+ */
+static const perft_position_t perft_positions[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+     {48, 2039, 97862, 4085603, 193690690, 0}},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+     {6, 264, 9467, 422333, 15833292, 0}},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+     {46, 2079, 89890, 3894594, 164075551, 0}}
+};
+
+static u64 perft(gupta_position_t *pos, size_t depth)
+{
+    scored_move_t moves[MOVES_MAX];
+    size_t num_moves,
+           idx;
+    u64 nodes = 0;
+
+    if (depth == 0)
+        return 1;
+
+    num_moves = gen_moves(pos, GEN_ALL, moves);
+
+    /* Bulk counting. As only legal moves are generated, the moves at the last ply don't have to be
+     * made to be counted.
+     */
+    if (depth == 1)
+        return num_moves;
+
+    for (idx = 0; idx < num_moves; idx++)
+    {
+        move_t m;
+
+        UNPACK_MOVE(m, moves[idx].move);
+        (void)make_move(pos, &m, MOVE_NOSTRICT_VALIDATION);
+        nodes += perft(pos, depth - 1);
+        gupta_undo_move(pos);
+    }
+
+    return nodes;
+}
+
+static void show_nodes_and_time(u64 nodes, u64 ms)
+{
+    printf("nodes %llu, time %llu ms, nps %llu\n", nodes, ms, ms ? nodes * 1000 / ms : 0);
+}
+
+u64 gupta_perft(gupta_position_t *pos, size_t depth)
+{
+    UASSERT(depth <= GUPTA_SEARCH_DEPTH_MAX);
+
+    return perft(pos, depth);
+}
+
+int gupta_run_perft_suite(size_t depth)
+{
+    gupta_position_t *pos = gupta_create_position();
+    u64 total_nodes = 0,
+        total_ms = 0;
+    size_t i;
+    int all_ok = 1;
+
+    for (i = 0; i < ARRAY_SIZE(perft_positions); i++)
+    {
+        const perft_position_t *position = &perft_positions[i];
+        size_t position_depth = depth ? depth : position->default_depth;
+        u64 expected_nodes = 0,
+            nodes,
+            ms;
+
+        if (!gupta_set_board_from_fen(pos, position->fen))
+        {
+            UASSERT(0 && "invalid perft suite position");
+            all_ok = 0;
+            continue;
+        }
+
+        if (position_depth <= ARRAY_SIZE(position->nodes))
+            expected_nodes = position->nodes[position_depth - 1];
+
+        ms = timer_get_ms();
+        nodes = gupta_perft(pos, position_depth);
+        ms = timer_get_ms() - ms;
+
+        total_nodes += nodes;
+        total_ms += ms;
+
+        printf("%u. %s\n   depth %u, ", (unsigned int)(i + 1), position->fen,
+               (unsigned int)position_depth);
+        show_nodes_and_time(nodes, ms);
+
+        if (!expected_nodes)
+            printf("   (no expected node count for this depth)\n");
+        else if (nodes != expected_nodes)
+        {
+            printf("   ERROR: expected %llu nodes\n", expected_nodes);
+            all_ok = 0;
+        }
+    }
+
+    printf("Total: ");
+    show_nodes_and_time(total_nodes, total_ms);
+    printf("%s\n", all_ok ? "All node counts are correct." : "Some node counts are WRONG.");
+
+    gupta_destroy_position(pos);
+
+    return all_ok;
+}
+
+void gupta_show_perft(gupta_position_t *pos, size_t depth, int divide)
+{
+    scored_move_t moves[MOVES_MAX];
+    size_t num_moves,
+           idx;
+    u64 nodes = 0,
+        ms;
+
+    UASSERT(depth <= GUPTA_SEARCH_DEPTH_MAX);
+
+    ms = timer_get_ms();
+
+    if (!divide || (depth == 0))
+        nodes = gupta_perft(pos, depth);
+    else
+    {
+        num_moves = gen_moves(pos, GEN_ALL, moves);
+
+        for (idx = 0; idx < num_moves; idx++)
+        {
+            move_t m;
+            u64 move_nodes;
+
+            UNPACK_MOVE(m, moves[idx].move);
+            (void)make_move(pos, &m, MOVE_NOSTRICT_VALIDATION);
+            move_nodes = perft(pos, depth - 1);
+            gupta_undo_move(pos);
+
+            printf("%s %llu\n", gupta_move_to_can(&m), move_nodes);
+            nodes += move_nodes;
+        }
+    }
+
+    ms = timer_get_ms() - ms;
+
+    show_nodes_and_time(nodes, ms);
+}
@@ -0,0 +1,41 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef PERFT_PUBLIC_H
+#define PERFT_PUBLIC_H
+
+#include "board_public.h"
+#include "types.h"
+
+#include <stddef.h>
+
+/* Returns the number of leaf nodes of the game tree of position 'pos', 'depth' plies deep.
+ * This exercises the move generator and make/undo in isolation from the search, so that their
+ * correctness and speed can be measured.
+ */
+u64 gupta_perft(gupta_position_t *pos, size_t depth);
+
+/* Runs the built-in suite of perft positions, verifying their node counts. Each position is
+ * searched 'depth' plies deep, or to its default depth if 'depth' is 0. The nodes, time and
+ * nodes per second are shown for each position, and for the suite as a whole.
+ * Returns 1 if all node counts were as expected, or 0 otherwise.
+ */
+int gupta_run_perft_suite(size_t depth);
+
+/* Shows the node count for 'depth' plies, with the time and nodes per second. If 'divide' is
+ * nonzero, the node count for each move from position 'pos' is shown first.
+ */
+void gupta_show_perft(gupta_position_t *pos, size_t depth, int divide);
+
+#endif /* !defined(PERFT_PUBLIC_H) */
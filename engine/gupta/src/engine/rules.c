@@ -12,31 +12,18 @@
 */
 
 #include "rules.h"
+#include "bitops.h"
 #include "board.h"
 #include "common.h"
-#include "delta_movement_info.h"
+#include "eval.h"
+#include "material.h"
 #include "move.h"
 #include "piece.h"
-#include "search.h"
 #include "uassert.h"
+#include "zobrist.h"
 
 #include <stdlib.h>
 
-typedef struct
-{
-    int is_pawn_capture;
-} pseudo_move_t;
-
-gupta_result_t g_result;
-
-int g_tside;
-int g_oside;
-
-u8 g_castling;
-
-/* Booleans indicating whether a side castled. */
-int g_castle_booleans[2];
-
 const u8 g_castling_masks[][2] = {
     {
         WHITE_KING_IS_NOT_AVAILABLE | WHITE_KINGS_ROOK_IS_NOT_AVAILABLE,
@@ -48,128 +35,148 @@ const u8 g_castling_masks[][2] = {
     }
 };
 
-/* Location of the square containing the pawn that can be captured by an En Passant move, or 0x88
- * if there is no such square.
+/* Returns the pieces of both sides that attack 'sq', where the pieces on the squares in 'occupied'
+ * block the sliding pieces.
  */
-u8 g_en_passant;
-
-static void construct_pseudo_move(pseudo_move_t *pseudo_move)
+u64 attackers_to(const gupta_position_t *pos, int sq, u64 occupied)
 {
-    /* When the structure declaration changes, we want to be reminded that we have to initialize
-     * the new structure members.
-     */
-    UASSERT(sizeof(pseudo_move_t) == 0x04);
-
-    pseudo_move->is_pawn_capture = 0;
+    const u64 *white = pos->bitboards[WHITE],
+              *black = pos->bitboards[BLACK];
+    u64 bishops = white[BISHOP] | black[BISHOP] | white[QUEEN] | black[QUEEN],
+        rooks = white[ROOK] | black[ROOK] | white[QUEEN] | black[QUEEN];
+
+    return (g_pawn_attacks[BLACK][sq] & white[PAWN]) |
+           (g_pawn_attacks[WHITE][sq] & black[PAWN]) |
+           (g_knight_attacks[sq] & (white[KNIGHT] | black[KNIGHT])) |
+           (g_king_attacks[sq] & (white[KING] | black[KING])) |
+           (BISHOP_ATTACKS(sq, occupied) & bishops) |
+           (ROOK_ATTACKS(sq, occupied) & rooks);
 }
 
-static int is_pseudo_legal_move(const piece_t *piece, u8 destination, pseudo_move_t *pseudo_move)
+static int is_square_attacked(const gupta_position_t *pos, u8 location, int side)
 {
-    s8 delta = destination - piece->location;
-    u8 flags = g_delta_movement_info[0x77 + delta];
-    int piece_type = PIECE_TYPE(*piece);
-    int piece_side = PIECE_SIDE(*piece);
+    const u64 *pieces = pos->bitboards[side];
+    int sq = SQ64(location);
+    u64 occupied = OCCUPIED_SQUARES(pos);
 
-    construct_pseudo_move(pseudo_move);
+    /* A pawn of 'side' attacks the square if a pawn of the other side on the square would attack
+     * the pawn of 'side'.
+     */
+    return (g_pawn_attacks[side ^ 1][sq] & pieces[PAWN]) ||
+           (g_knight_attacks[sq] & pieces[KNIGHT]) ||
+           (g_king_attacks[sq] & pieces[KING]) ||
+           (BISHOP_ATTACKS(sq, occupied) & (pieces[BISHOP] | pieces[QUEEN])) ||
+           (ROOK_ATTACKS(sq, occupied) & (pieces[ROOK] | pieces[QUEEN]));
+}
 
-    if (DELTA_MOVEMENT_IS_VALID_FOR_PIECE(flags, piece_type))
-        return 1;
-    else if (piece_type == PAWN)
-    {
-        if ((delta == (piece_side == WHITE ? 0x0F : -0x0F)) ||
-            (delta == (piece_side == WHITE ? 0x11 : -0x11)))
-        {
-            /* One-step capturing pawn move. */
-            pseudo_move->is_pawn_capture = 1;
-            return 1;
-        }
-        else if (delta == (piece_side == WHITE ? 0x10 : -0x10))
-        {
-            /* One-step non-capturing pawn move. */
-            return 1;
-        }
-        else if (((piece->location & 0xF0) == (piece_side == WHITE ? 0x10 : -0x60)) &&
-                 (delta == (piece_side == WHITE ? 0x20 : -0x20)))
-        {
-            /* Two-step non-capturing pawn move. */
-            return 1;
-        }
-    }
+/* In a static exchange, the king may capture too, but only as the very last piece. */
+#define SEE_KING_VALUE 10000
 
-    return 0;
+static int see_piece_value(int piece_type)
+{
+    return piece_type == KING ? SEE_KING_VALUE : g_piece_values[piece_type];
 }
 
-static int is_path_blocked(u8 from, u8 to)
+int see(const gupta_position_t *pos, const move_t *m)
 {
-    s8 delta,
-       base;
-    u8 board_index;
-
-    delta = to - from;
-    base = g_delta_bases[abs(delta)];
-    if (delta < 0)
-        base = -base;
-
-    /* One-step movements can't have a blocked path, as there are no squares in between the points.
-     * The algorithm actually already covers this case, and we wouldn't need to manually check for
-     * it here, but it's more explicit.
-     */
-    if (base == delta)
-        return 0;
-
-    for (board_index = from + base; ((board_index & 0x88) == 0) && (board_index != to); board_index += base)
+    /* The order in which the attackers of either side take part in the exchange. */
+    static const int attacker_types[] = {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING};
+    int gains[32];
+    int to = SQ64(m->to);
+    s8 attacker = pos->board[m->from],
+       victim = pos->board[m->to];
+    u64 occupied = OCCUPIED_SQUARES(pos),
+        diagonal_sliders = pos->bitboards[WHITE][BISHOP] | pos->bitboards[BLACK][BISHOP] |
+                           pos->bitboards[WHITE][QUEEN] | pos->bitboards[BLACK][QUEEN],
+        straight_sliders = pos->bitboards[WHITE][ROOK] | pos->bitboards[BLACK][ROOK] |
+                           pos->bitboards[WHITE][QUEEN] | pos->bitboards[BLACK][QUEEN],
+        attacker_bb = BB_SQUARE(SQ64(m->from)),
+        attackers;
+    int attacker_value,
+        side = pos->tside,
+        d = 0;
+
+    UASSERT(attacker);
+
+    if (victim)
+        gains[0] = g_piece_values[PIECE_TYPE(victim)];
+    else if ((PIECE_TYPE(attacker) == PAWN) && ((m->to & 0x0F) != (m->from & 0x0F)))
     {
-        if (g_board[board_index])
-            return 1;
+        /* En Passant. The captured pawn isn't on the destination square, but it could block a
+         * slider behind it.
+         */
+        gains[0] = g_piece_values[PAWN];
+        occupied &= ~BB_SQUARE(SQ64(pos->en_passant));
     }
+    else
+        gains[0] = 0;
 
-    return 0;
-}
+    attacker_value = see_piece_value(PIECE_TYPE(attacker));
+    if (m->promote != PROMOTE_NONE)
+    {
+        gains[0] += g_piece_values[m->promote] - g_piece_values[PAWN];
+        attacker_value = g_piece_values[m->promote];
+    }
 
-static int is_square_attacked(u8 location, int side)
-{
-    size_t i;
+    attackers = attackers_to(pos, to, occupied);
 
-    for (i = g_piece_ranges[side].begin; i < g_piece_ranges[side].end; i++)
+    /* The exchange on the destination square continues with the least valuable attacker of either
+     * side, until one of the sides runs out of attackers. Every entry of 'gains' is the material
+     * balance from the perspective of the side that made the capture, assuming that the capturing
+     * piece is captured in turn.
+     */
+    do
     {
-        const piece_t *p = &g_pieces[i];
-        const int piece_type = PIECE_TYPE(*p);
-        pseudo_move_t pseudo_move;
-
-        /* We expect to only loop over the pieces of 'side'. */
-        UASSERT(PIECE_SIDE(*p) == side);
+        size_t i;
 
-        if (p->is_captured)
-            continue;
-        else if (p->location == location)
-            continue; /* A piece can't attack itself. */
+        d++;
+        gains[d] = attacker_value - gains[d - 1];
 
-        /* Check if the piece can reach the square we're evaluating. */
-        if (is_pseudo_legal_move(p, location, &pseudo_move))
+        /* If neither continuing nor stopping the exchange can make a difference anymore, the
+         * remaining captures needn't be examined.
+         */
+        if ((-gains[d - 1] < 0) && (gains[d] < 0))
+            break;
+
+        /* Once a piece has taken part in the exchange, the sliders behind it may attack too. */
+        occupied &= ~attacker_bb;
+        attackers |= (BISHOP_ATTACKS(to, occupied) & diagonal_sliders) |
+                     (ROOK_ATTACKS(to, occupied) & straight_sliders);
+        attackers &= occupied;
+
+        side = !side;
+        attacker_bb = 0;
+        for (i = 0; i < ARRAY_SIZE(attacker_types); i++)
         {
-            if (piece_type == KNIGHT)
-                return 1; /* For knights, paths can't be blocked. The knight can attack. */
-            else if (piece_type == PAWN)
+            u64 bb = attackers & pos->bitboards[side][attacker_types[i]];
+
+            if (bb)
             {
-                if (pseudo_move.is_pawn_capture)
-                    return 1;
+                attacker_bb = bb & (~bb + 1);
+                attacker_value = see_piece_value(attacker_types[i]);
+                break;
             }
-            else if (!is_path_blocked(p->location, location))
-                return 1;
         }
+    } while (attacker_bb && ((size_t)d + 1 < ARRAY_SIZE(gains)));
+
+    /* Either side may decline to capture, so the material balance is minimaxed backwards. */
+    while (--d)
+    {
+        if (gains[d] > -gains[d - 1])
+            gains[d - 1] = -gains[d];
     }
 
-    return 0;
+    return gains[0];
 }
 
-int gupta_is_game_over(gupta_result_t *result)
+int gupta_is_game_over(gupta_position_t *pos, gupta_result_t *result)
 {
     int retval = 0;
     gupta_result_t local_result = GUPTA_RESULT_NONE;
 
-    if (g_result != GUPTA_RESULT_NONE)
+    if (pos->result != GUPTA_RESULT_NONE)
     {
-        local_result = g_result;
+        local_result = pos->result;
         retval = 1;
         goto done;
     }
@@ -177,23 +184,23 @@ int gupta_is_game_over(gupta_result_t *result)
     /* Before checking whether any move can be made, check whether there is insufficient mating
      * material.
      */
-    if (is_draw_by_insufficient_material())
+    if (is_draw_by_insufficient_material(pos))
     {
         local_result = GUPTA_RESULT_DRAW_BY_INSUFFICIENT_MATERIAL;
         retval = 1;
         goto done;
     }
 
-    if (can_make_any_move(g_tside))
+    if (can_make_any_move(pos, pos->tside))
     {
         /* At least one valid move could still be made, hence the game is not over. */
         UASSERT(local_result == GUPTA_RESULT_NONE);
         goto done;
     }
 
-    if (is_king_in_check(g_tside))
+    if (is_king_in_check(pos, pos->tside))
     {
-        if (g_tside == WHITE)
+        if (pos->tside == WHITE)
             local_result = GUPTA_RESULT_CHECKMATE_BY_BLACK;
         else
             local_result = GUPTA_RESULT_CHECKMATE_BY_WHITE;
@@ -211,219 +218,95 @@ done:
     return retval;
 }
 
-void gupta_new_game()
+void gupta_new_game(gupta_position_t *pos)
 {
-    reset_board_and_pieces();
+    reset_board(pos);
 
-    g_result = GUPTA_RESULT_NONE;
+    pos->result = GUPTA_RESULT_NONE;
 
-    g_tside = WHITE;
-    g_oside = BLACK;
+    pos->tside = WHITE;
+    pos->oside = BLACK;
     UASSERT((WHITE ^ 1) == BLACK); /* Implies '(BLACK ^ 1) == WHITE'. */
 
-    g_history_idx = 0;
+    pos->history_idx = 0;
 
-    g_castling = 0;
-    g_castle_booleans[WHITE] = 0;
-    g_castle_booleans[BLACK] = 0;
+    pos->castling = 0;
+    pos->castle_booleans[WHITE] = 0;
+    pos->castle_booleans[BLACK] = 0;
 
-    g_en_passant = 0x88;
+    pos->en_passant = 0x88;
 
-    g_is_resignation_sensible = 0;
+    pos->halfmove_clock = 0;
+
+    pos->hash_key = compute_hash_key(pos);
 }
 
 /* The player who has the move resigns. */
-void gupta_resign()
+void gupta_resign(gupta_position_t *pos)
 {
-    if (g_tside == WHITE)
-        g_result = GUPTA_RESULT_RESIGNATION_BY_WHITE;
-    else if (g_tside == BLACK)
-        g_result = GUPTA_RESULT_RESIGNATION_BY_BLACK;
+    if (pos->tside == WHITE)
+        pos->result = GUPTA_RESULT_RESIGNATION_BY_WHITE;
+    else if (pos->tside == BLACK)
+        pos->result = GUPTA_RESULT_RESIGNATION_BY_BLACK;
 }
 
-/* The game is considered to be a draw by insufficient material only under any of the following
- * conditions:
- *     - Both sides only have a king.
- *     - One side only has a king and bishop, the other only a king.
- *     - One side only has a king and knight, the other only a king.
- *     - Both sides only have a king and bishops of the same type.
+/* Returns whether neither side has enough material left to checkmate, see 'material.c' for the
+ * exact conditions.
  */
-int is_draw_by_insufficient_material(void)
+int is_draw_by_insufficient_material(const gupta_position_t *pos)
 {
-    int knights[2] = {0, 0},
-        has_light_square_bishop[2] = {0, 0},
-        has_dark_square_bishop[2] = {0, 0},
-        side;
-
-    for (side = 0; side < 2; side++)
-    {
-        size_t i;
-
-        for (i = g_piece_ranges[side].begin; i < g_piece_ranges[side].end; i++)
-        {
-            int t;
-            u8 piece_location = g_pieces[i].location;
+    return material_probe(pos)->is_insufficient_material;
+}
 
-            if (g_pieces[i].is_captured)
-                continue;
-            else
-            {
-                /* We assume there is a piece on the given square if it's not captured. */
-                UASSERT(g_board[piece_location]);
-                /* We assume that the piece is indeed owned by 'side'. */
-                UASSERT(PIECE_SIDE(*g_board[piece_location]) == side);
-            }
+/* Returns whether the position occurred before with the same side to move. Only the positions
+ * since the last capture, pawn move or null move are compared, as no position from before such a
+ * move can occur again after it (see 'halfmove_clock' in 'board.h').
+ */
+int is_repetition(const gupta_position_t *pos)
+{
+    size_t num_reversible = (size_t)pos->halfmove_clock,
+           i;
 
-            t = PIECE_TYPE(g_pieces[i]);
-            if (t == KNIGHT)
-                knights[side]++;
-            else if (t == BISHOP)
-            {
-                if (is_light_square(piece_location))
-                    has_light_square_bishop[side] = 1;
-                else
-                    has_dark_square_bishop[side] = 1;
-            }
-            else if ((t == QUEEN) || (t == ROOK) || (t == PAWN))
-            {
-                /* At least one side has mating material or potential mating material. */
-                return 0;
-            }
-        }
-    }
+    /* The moves before the board was set up are unknown. */
+    if (num_reversible > pos->history_idx)
+        num_reversible = pos->history_idx;
 
-    /* Do the following checks for both sides. */
-    for (side = 0; side < 2; side++)
+    /* It takes at least two moves by each side to get back to the same position. */
+    for (i = 4; i <= num_reversible; i += 2)
     {
-        int other_side = side ^ 1,
-            other_side_has_nothing = (knights[other_side] == 0) &&
-                                     (!has_light_square_bishop[other_side] &&
-                                      !has_dark_square_bishop[other_side]),
-            side_has_only_one_type_of_bishop = has_light_square_bishop[side] ^
-                                               has_dark_square_bishop[side],
-            other_side_has_only_one_type_of_bishop = has_light_square_bishop[other_side] ^
-                                                     has_dark_square_bishop[other_side];
-
-        /* Do both sides have no knights, and only bishops of the same type (that is, the bishops
-         * of one side are of the same type as those of the other)?
-         */
-        if ((knights[side] == 0) &&
-            side_has_only_one_type_of_bishop &&
-            (knights[other_side] == 0) &&
-            other_side_has_only_one_type_of_bishop &&
-            /* If we know for sure that both sides have bishops, and only bishops of the same type
-             * (individually, that is), then the following comparison tells us whether the bishops
-             * of both sides are of the same type, since if the comparison is true, then it implies
-             * that 'has_dark_square_bishop[side] == has_dark_square_bishop[other_side]' is true as
-             * well, as the 'has_dark_square_bishop' bishop array will contain zeroes if the
-             * 'has_light_square_bishop' array contains ones, and vice versa.
-             */
-            (has_light_square_bishop[side] == has_light_square_bishop[other_side]))
-        {
-            return 1;
-        }
-        /* Does one side only have one or fewer knights and no bishops, and the other nothing? */
-        else if ((knights[side] <= 1) &&
-                 (!has_light_square_bishop[side] && !has_dark_square_bishop[side]) &&
-                 other_side_has_nothing)
-        {
-            return 1;
-        }
-        /* Does one side have no knights and no bishop pairs (in other words, does one side have no
-         * knights and no bishops or only bishops of the same type), and the other nothing?
-         */
-        else if ((knights[side] == 0) &&
-                 !(has_light_square_bishop[side] && has_dark_square_bishop[side]) &&
-                 other_side_has_nothing)
-        {
+        if (pos->history_stack[pos->history_idx - i].hash_key == pos->hash_key)
             return 1;
-        }
     }
 
     return 0;
 }
 
-int is_king_in_check(int side)
+/* The game is drawn by the fifty-move rule once both sides made fifty moves without a capture or a
+ * pawn move, unless the last of these moves checkmated.
+ */
+int is_draw_by_fifty_move_rule(gupta_position_t *pos)
 {
-    const piece_t *p = &g_pieces[side == WHITE ? g_piece_ranges[WHITE].begin : g_piece_ranges[BLACK].begin];
-
-    /* Make sure we got the king that we expected to get, and that his majesty is not a captured
-     * piece.
-     */
-    UASSERT(p && (PIECE_SIDE(*p) == side) && (PIECE_TYPE(*p) == KING) && !p->is_captured);
-
-    return is_square_attacked(p->location, PIECE_SIDE_OPPOSITE(*p));
+    return (pos->halfmove_clock >= 100) &&
+           (!is_king_in_check(pos, pos->tside) || can_make_any_move(pos, pos->tside));
 }
 
-void set_turn(int side)
+int is_king_in_check(const gupta_position_t *pos, int side)
 {
-    assert((side == WHITE) || (side == BLACK));
-    g_tside = side;
-    g_oside = side ^ 1;
+    /* His majesty must be on the board. */
+    UASSERT(pos->bitboards[side][KING]);
+
+    return is_square_attacked(pos, SQ88(KING_SQUARE(pos, side)), side ^ 1);
 }
 
-void switch_turn()
+void set_turn(gupta_position_t *pos, int side)
 {
-    g_tside ^= 1;
-    g_oside ^= 1;
+    assert((side == WHITE) || (side == BLACK));
+    pos->tside = side;
+    pos->oside = side ^ 1;
 }
 
-int was_move_valid(const move_t *m, const castling_t *castling)
+void switch_turn(gupta_position_t *pos)
 {
-    const piece_t *piece = g_board[m->to];
-
-    UASSERT(piece);
-
-    /* The piece was just moved by the side whose turn it is not anymore. */
-    UASSERT(PIECE_SIDE(*piece) == g_oside);
-
-    /* TODO XXX
-     * CEC-Protocol says that the engine _must_ validate the user's moves.
-     * So then, perhaps create two routines (for performance reasons) ? One to validate
-     * user moves, which strictly validates all the chess rules, and one routine (the current
-     * routine) that can be used to validate moves generated by the move generator.
-     */
-
-    /* The side whose turn it is not has just made a move, so check whether their king is in
-     * check.
-     */
-    if (is_king_in_check(g_oside))
-        return 0;
-
-    if (castling->is_castling)
-    {
-        u8 locations[][2] = {{0x05, 0x03}, {0x75, 0x73}};
-
-        /* If the king's square was attacked after the castling move was performed, it was also
-         * attacked before the castling move was performed, which would render the castling move
-         * illegal.
-         */
-        if (is_square_attacked(m->from, g_tside))
-            return 0;
-
-        /* If either the king or the particular rook has moved, castling is illegal. */
-        if (BIT_IS_ANY_SET(g_castling, g_castling_masks[g_oside][castling->is_castling_queenside]))
-            return 0;
-
-        if (castling->is_castling_queenside)
-        {
-            /* Normally, we check whether the path is blocked when castling. However, since
-             * make_move() already checks whether the destinations for both the king and rook are
-             * indeed unoccupied, we only have to check, for queenside castling moves, one square,
-             * namely the 0x01 or 0x71 square (which will, after castling, not be occupied, and
-             * therefore wasn't checked by make_move()).
-             */
-            if (g_board[(g_oside == WHITE) ? 0x01 : 0x71])
-                return 0;
-        }
-
-        /* If the square that the king has to "move through" during castling is attacked, castling
-         * is illegal. The king's final destination however, is covered by the earlier
-         * is_king_in_check() call, and does not need to be checked here.
-         */
-        if (is_square_attacked(locations[g_oside][castling->is_castling_queenside], g_tside))
-            return 0;
-    }
-
-    return 1;
+    pos->tside ^= 1;
+    pos->oside ^= 1;
 }
@@ -17,27 +17,26 @@
 #include "rules_public.h"
 #include "move.h"
 
-extern gupta_result_t g_result;
-
-extern int g_tside; /* Side whose turn it is. */
-extern int g_oside; /* Side whose turn it is not (opposite/other side, hence 'oside'). */
-
 #define WHITE_KING_IS_NOT_AVAILABLE        (1 << 0)
 #define BLACK_KING_IS_NOT_AVAILABLE        (1 << 1)
 #define WHITE_KINGS_ROOK_IS_NOT_AVAILABLE  (1 << 2)
 #define BLACK_KINGS_ROOK_IS_NOT_AVAILABLE  (1 << 3)
 #define WHITE_QUEENS_ROOK_IS_NOT_AVAILABLE (1 << 4)
 #define BLACK_QUEENS_ROOK_IS_NOT_AVAILABLE (1 << 5)
-extern u8 g_castling;
-extern int g_castle_booleans[2];
 extern const u8 g_castling_masks[][2];
 
-extern u8 g_en_passant;
-
-int is_draw_by_insufficient_material(void);
-int is_king_in_check(int side);
-void set_turn(int side);
-void switch_turn(void);
-int was_move_valid(const move_t *m, const castling_t *castling);
+u64 attackers_to(const gupta_position_t *pos, int sq, u64 occupied);
+int is_draw_by_fifty_move_rule(gupta_position_t *pos);
+int is_draw_by_insufficient_material(const gupta_position_t *pos);
+int is_king_in_check(const gupta_position_t *pos, int side);
+int is_repetition(const gupta_position_t *pos);
+
+/* Static exchange evaluation: returns the material won (or, if negative, lost) by the side to move
+ * when making the move 'm', when both sides keep on capturing on its destination square with their
+ * least valuable pieces for as long as that's profitable. Pins aren't taken into account.
+ */
+int see(const gupta_position_t *pos, const move_t *m);
+void set_turn(gupta_position_t *pos, int side);
+void switch_turn(gupta_position_t *pos);
 
 #endif /* !defined(RULES_H) */
@@ -14,6 +14,8 @@
 #ifndef RULES_PUBLIC_H
 #define RULES_PUBLIC_H
 
+#include "board_public.h"
+
 typedef enum
 {
     GUPTA_RESULT_NONE,
@@ -25,8 +27,8 @@ typedef enum
     GUPTA_RESULT_RESIGNATION_BY_BLACK
 } gupta_result_t;
 
-int gupta_is_game_over(gupta_result_t *result);
-void gupta_new_game(void);
-void gupta_resign(void);
+int gupta_is_game_over(gupta_position_t *pos, gupta_result_t *result);
+void gupta_new_game(gupta_position_t *pos);
+void gupta_resign(gupta_position_t *pos);
 
 #endif /* !defined(RULES_PUBLIC_H) */
@@ -0,0 +1,161 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Standard Algebraic Notation (SAN), the notation of the moves in PGN files and in most chess
+ * literature, such as 'Nf3', 'exd5', 'Rad1', 'e8=Q+' and 'O-O'. Unlike Coordinate Algebraic
+ * Notation, a SAN move only makes sense in the position it is played in, as it names the source
+ * square of a move only as far as needed to tell it apart from the other legal moves.
+ */
+
+#include "san_public.h"
+#include "board.h"
+#include "common.h"
+#include "move.h"
+#include "piece.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Returns the type of the piece denoted by 'letter', as in 'Nf3', or NOPIECE. */
+static int piece_type_from_letter(char letter)
+{
+    switch (letter)
+    {
+    case 'N':
+        return KNIGHT;
+    case 'B':
+        return BISHOP;
+    case 'R':
+        return ROOK;
+    case 'Q':
+        return QUEEN;
+    case 'K':
+        return KING;
+    default:
+        return NOPIECE;
+    }
+}
+
+static int is_file(char c)
+{
+    return (c >= 'a') && (c <= 'h');
+}
+
+static int is_rank(char c)
+{
+    return (c >= '1') && (c <= '8');
+}
+
+/* Parses 'san', a move in Standard Algebraic Notation, and stores the legal move of position 'pos'
+ * that it denotes in 'm'. Check and checkmate indicators and annotations, as in 'Qxf7#' and
+ * 'e4!?', are ignored, and so are missing capture indicators and '=' signs of promotions. Returns 0
+ * if 'san' doesn't denote exactly one legal move.
+ */
+int gupta_parse_san_move(gupta_position_t *pos, const char *san, move_t *m)
+{
+    scored_move_t moves[MOVES_MAX];
+    size_t len = strlen(san),
+           num_moves,
+           idx,
+           num_matches = 0;
+    int piece_type = PAWN,
+        promote = PROMOTE_NONE,
+        castling_direction = 0,
+        from_file = -1,
+        from_rank = -1,
+        to = 0x88;
+
+    while ((len > 0) && strchr("+#!?", san[len - 1]))
+        len--;
+
+    /* Castling is also written with zeros, as in '0-0'. */
+    if ((len == 3) && (!strncmp(san, "O-O", len) || !strncmp(san, "0-0", len)))
+        castling_direction = +2;
+    else if ((len == 5) && (!strncmp(san, "O-O-O", len) || !strncmp(san, "0-0-0", len)))
+        castling_direction = -2;
+    else
+    {
+        size_t i = 0;
+
+        if ((len > 0) && (piece_type_from_letter(san[0]) != NOPIECE))
+        {
+            piece_type = piece_type_from_letter(san[0]);
+            i++;
+        }
+
+        /* A promotion, as in 'e8=Q' or 'e8Q'. */
+        if ((piece_type == PAWN) && (len > 0) && (piece_type_from_letter(san[len - 1]) != NOPIECE))
+        {
+            promote = piece_type_from_letter(san[len - 1]);
+            if (promote == KING)
+                return 0;
+            len--;
+            if ((len > 0) && (san[len - 1] == '='))
+                len--;
+        }
+
+        /* The destination square comes last. */
+        if ((len < i + 2) || !is_file(san[len - 2]) || !is_rank(san[len - 1]))
+            return 0;
+        to = ((san[len - 1] - '1') << 4) | (san[len - 2] - 'a');
+        len -= 2;
+
+        if ((len > i) && (san[len - 1] == 'x'))
+            len--;
+
+        /* Whatever is left tells the source square apart, as in 'exd5', 'Nbd2', 'R1e2' and
+         * 'Qh4e1'.
+         */
+        if ((i < len) && is_file(san[i]))
+            from_file = san[i++] - 'a';
+        if ((i < len) && is_rank(san[i]))
+            from_rank = san[i++] - '1';
+        if (i != len)
+            return 0;
+    }
+
+    num_moves = gen_moves(pos, GEN_ALL, moves);
+
+    for (idx = 0; idx < num_moves; idx++)
+    {
+        move_t candidate;
+        int candidate_type;
+
+        UNPACK_MOVE(candidate, moves[idx].move);
+        candidate_type = PIECE_TYPE(pos->board[candidate.from]);
+
+        if (castling_direction)
+        {
+            /* A castling move is a move of the king two squares from its initial square. */
+            if ((candidate_type != KING) || ((candidate.from & 0x0F) != 4) ||
+                (candidate.to != candidate.from + castling_direction))
+            {
+                continue;
+            }
+        }
+        else if ((candidate_type != piece_type) || (candidate.to != to) ||
+                 (candidate.promote != promote) ||
+                 ((from_file >= 0) && ((candidate.from & 0x0F) != from_file)) ||
+                 ((from_rank >= 0) && ((candidate.from >> 4) != from_rank)))
+        {
+            continue;
+        }
+
+        *m = candidate;
+        num_matches++;
+    }
+
+    return num_matches == 1;
+}
@@ -0,0 +1,23 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef SAN_PUBLIC_H
+#define SAN_PUBLIC_H
+
+#include "board_public.h"
+#include "move_public.h"
+
+int gupta_parse_san_move(gupta_position_t *pos, const char *san, move_t *m);
+
+#endif /* !defined(SAN_PUBLIC_H) */
@@ -13,80 +13,765 @@
 
 #include "search.h"
 #include "board.h"
+#include "book.h"
 #include "common.h"
+#include "compiler_specific.h"
+#include "enforce.h"
 #include "eval.h"
 #include "move.h"
+#include "tablebase.h"
+#include "timer.h"
+#include "ttable.h"
 #include "uassert.h"
 
-#include <sys/time.h>
+#include <stdlib.h>
 
 #include "rules.h" /* TODO: remove if unused */
 #include "log.h" /* TODO: remove if unused */
 #include <stdio.h> /* TODO: remove if unused */
 #include <string.h> /* TODO: remove if unused */
 
-gupta_cb_search_interrupt_t g_search_interrupt = NULL;
-
-/* Represents the best move found so far. */
-size_t g_best_move_idx;
-
 /* The resignation threshold is the minimum score necessary to denote an unavoidable (theoretically
  * at least) loss.
  */
 #define RESIGNATION_THRESHOLD (-(SEARCH_INFINITY - GUPTA_SEARCH_DEPTH_MAX))
 
-/* Indicates whether resignation is a sensible option (here meaning that, theoretically speaking,
- * losing is unavoidable).
+/* Scores at least this high (or at least this low, when negated) denote a checkmate. Such scores
+ * depend on the game tree height they were found at, see score_to_tt() and score_from_tt().
+ */
+#define CHECKMATE_THRESHOLD (SEARCH_INFINITY - GUPTA_SEARCH_DEPTH_MAX)
+
+/* The tunable search parameters, indexable by the SEARCH_PARAM_* constants. They can be changed
+ * with gupta_set_search_param(), so that for example different settings can be played against
+ * each other. Unlike the rest of the search state, they are shared by all searches, so they can
+ * only be changed while no search is running (see tt_lock_if_idle()).
+ */
+enum
+{
+    SEARCH_PARAM_NULL_MOVE,
+    SEARCH_PARAM_NULL_MOVE_REDUCTION,
+    SEARCH_PARAM_NULL_MOVE_VERIFICATION_DEPTH,
+    SEARCH_PARAM_LMR,
+    SEARCH_PARAM_LMR_FULL_DEPTH_MOVES,
+    SEARCH_PARAM_LMR_MIN_DEPTH,
+    SEARCH_PARAM_LMR_REDUCTION
+};
+static gupta_search_param_t search_params[] = {
+    {"Null move pruning",            1, 1, 0, 1},
+    {"Null move reduction",          0, 2, 1, 4},
+    {"Null move verification depth", 0, 6, 0, GUPTA_SEARCH_DEPTH_MAX}, /* 0 means never. */
+    {"Late move reductions",         1, 1, 0, 1},
+    {"LMR full depth moves",         0, 4, 1, MOVES_MAX},
+    {"LMR minimum depth",            0, 3, 2, GUPTA_SEARCH_DEPTH_MAX},
+    {"LMR reduction",                0, 1, 1, 4}
+};
+#define SEARCH_PARAM(idx) (search_params[(idx)].value)
+
+static u64 get_elapsed_search_time(const gupta_search_t *s)
+{
+    return timer_get_ms() - s->search_start_time;
+}
+
+/* Once the hard time limit is reached, the search is aborted, even if that means that the
+ * iteration in progress is thrown away.
+ */
+static int is_hard_time_limit_reached(const gupta_search_t *s)
+{
+    if (ATOMIC_LOAD(&s->is_pondering))
+        return 0;
+
+    return get_elapsed_search_time(s) >= s->hard_time_limit;
+}
+
+/* The soft time limit is checked between iterations. An iteration usually takes several times
+ * longer than all the previous iterations together, so once half the time that the search aims to
+ * take has been used up, starting another iteration would most likely be a waste of time.
+ */
+static int is_soft_time_limit_reached(const gupta_search_t *s)
+{
+    if (ATOMIC_LOAD(&s->is_pondering))
+        return 0;
+
+    return get_elapsed_search_time(s) >= s->soft_time_limit;
+}
+
+/* When playing on a clock, see gupta_set_search_clock(), the time control is assumed to end after
+ * CLOCK_MOVES_TO_GO_DEFAULT more moves if it doesn't say, CLOCK_SAFETY_MARGIN milliseconds are
+ * kept in reserve for the time it takes to communicate a move, and a search takes at most
+ * CLOCK_MAX_TIME_FACTOR times the time that it aims to take.
+ */
+#define CLOCK_MOVES_TO_GO_DEFAULT 30
+#define CLOCK_SAFETY_MARGIN       50
+#define CLOCK_MAX_TIME_FACTOR     4
+
+/* Sets the time limits of a search. With a fixed search time, the search aims to take that time,
+ * which is also its hard time limit. When playing on a clock, the time that is left (less the
+ * safety margin) is divided evenly over the moves until the time control, and the increment is
+ * added, as it is earned back by moving. A single search never takes more than half of the time
+ * that is left, except for the last move before the time control.
+ */
+static void allocate_time(gupta_search_t *s)
+{
+    if (ATOMIC_LOAD(&s->use_clock))
+    {
+        size_t moves_to_go = s->clock_moves_to_go ? s->clock_moves_to_go :
+                                                    CLOCK_MOVES_TO_GO_DEFAULT;
+        u64 usable = s->clock_time,
+            max_time;
+
+        if (usable > 2 * CLOCK_SAFETY_MARGIN)
+            usable -= CLOCK_SAFETY_MARGIN;
+        else
+            usable /= 2;
+
+        max_time = (moves_to_go == 1) ? usable : usable / 2;
+        s->target_time = usable / moves_to_go + s->clock_increment;
+        s->hard_time_limit = s->target_time * CLOCK_MAX_TIME_FACTOR;
+
+        if (s->target_time > max_time)
+            s->target_time = max_time;
+        if (s->hard_time_limit > max_time)
+            s->hard_time_limit = max_time;
+
+        /* Even without any time left, the search has to come up with a move. */
+        if (s->hard_time_limit == 0)
+            s->hard_time_limit = 1;
+    }
+    else
+    {
+        s->target_time = s->search_time;
+        s->hard_time_limit = s->search_time;
+    }
+
+    s->soft_time_limit = s->target_time / 2;
+}
+
+/* Once a pondering search turns into a normal one, see gupta_ponderhit(), its time limits are set
+ * again, as the clock was most likely updated since the pondering started.
+ */
+static void check_ponderhit(gupta_search_t *s)
+{
+    if (s->awaits_ponderhit && !ATOMIC_LOAD_ACQUIRE(&s->is_pondering))
+    {
+        s->awaits_ponderhit = 0;
+        allocate_time(s);
+    }
+}
+
+/* When playing on a clock, the time is spent where it matters most, by adjusting the soft time
+ * limit after each iteration. If the score dropped (the best move failed low), the search gets
+ * twice the time, as it's better to find a way out now than to notice the trouble too late. If
+ * the best move hasn't changed for STABLE_ITERATIONS iterations, it dominates the other moves,
+ * and the search gets half the time. If there is only one legal move, there is nothing to decide.
+ * The hard time limit still applies in any case.
+ */
+#define FAIL_LOW_MARGIN   30
+#define STABLE_ITERATIONS 4
+
+static void adjust_time_limit(gupta_search_t *s, int has_failed_low, size_t num_stable_iterations)
+{
+    u64 time = s->target_time;
+
+    if (!ATOMIC_LOAD(&s->use_clock))
+        return;
+
+    if (s->num_root_moves == 1)
+        time = 0;
+    else if (has_failed_low)
+        time *= 2;
+    else if (num_stable_iterations >= STABLE_ITERATIONS)
+        time /= 2;
+
+    s->soft_time_limit = time / 2;
+}
+
+/* Move ordering scores. The moves are searched in this order: first the hash move (the best move
+ * found by an earlier search of the position, see 'ttable.h'), then the captures and queen
+ * promotions that don't lose material, then the killer moves, then the other moves (in order of
+ * their history scores), and finally the captures that do lose material. See next_move().
+ */
+#define MOVE_SCORE_HASH_MOVE      (1 << 30)
+#define MOVE_SCORE_GOOD_CAPTURE   (1 << 20)
+#define MOVE_SCORE_KILLER         (1 << 19)
+#define MOVE_SCORE_QUIET          0
+#define MOVE_SCORE_LOSING_CAPTURE (-(1 << 20))
+
+/* Once a history score (see 'struct gupta_search') reaches HISTORY_SCORE_MAX, all scores are
+ * halved, so that they never compete with the killer moves.
+ */
+#define HISTORY_SCORE_MAX (1 << 16)
+
+/* Scores a capture or a promotion using MVV-LVA (Most Valuable Victim, Least Valuable Attacker),
+ * such that for example capturing a queen is tried before capturing a pawn. Unless the attacker is
+ * worth less than its victim, the static exchange evaluation decides whether the move loses
+ * material.
+ */
+static int score_capture(const gupta_position_t *pos, const move_t *m)
+{
+    s8 attacker = pos->board[m->from],
+       victim = pos->board[m->to];
+    int attacker_value = g_piece_values[PIECE_TYPE(attacker)],
+        victim_value;
+
+    if (victim)
+        victim_value = g_piece_values[PIECE_TYPE(victim)];
+    else if ((PIECE_TYPE(attacker) == PAWN) && ((m->to & 0x0F) != (m->from & 0x0F)))
+        victim_value = g_piece_values[PAWN]; /* En Passant. */
+    else
+        victim_value = 0;
+
+    if (m->promote != PROMOTE_NONE)
+        victim_value += g_piece_values[m->promote] - g_piece_values[PAWN];
+
+    if ((attacker_value > victim_value) && (see(pos, m) < 0))
+        return MOVE_SCORE_LOSING_CAPTURE + 10 * victim_value - attacker_value;
+    return MOVE_SCORE_GOOD_CAPTURE + 10 * victim_value - attacker_value;
+}
+
+/* The stages of next_move(). Generating the moves in stages saves work whenever a move searched
+ * early causes a beta cutoff: the hash move is searched before any move is generated, the killer
+ * moves before the non-capturing moves are generated, and the moves of a stage aren't scored until
+ * the stage is reached.
  */
-int g_is_resignation_sensible;
+typedef enum
+{
+    STAGE_HASH_MOVE,
+    STAGE_GEN_CAPTURES,
+    STAGE_GOOD_CAPTURES,
+    STAGE_KILLERS,
+    STAGE_GEN_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_DONE
+} stage_t;
 
-/* Private variable, use the gupta_get_search_depth() and gupta_set_search_depth() functions to
- * retrieve and change it.
+/* Hands out the moves of a position one by one, in the order of their move ordering scores, see
+ * next_move(). It lives on the stack of search() and quiesce(), so every node of the game tree has
+ * its own list of moves.
  */
-static size_t search_depth = GUPTA_SEARCH_DEPTH_MAX;
+typedef struct
+{
+    stage_t stage;
+    int captures_only; /* Whether only the captures that don't lose material are wanted. */
+    packed_move_t hash_move,
+                  killer_moves[NUM_KILLER_MOVES];
+    /* Once the other captures were handed out, the captures that lose material are moved to the
+     * beginning of 'moves', and the non-capturing moves are generated after them.
+     */
+    scored_move_t moves[MOVES_MAX];
+    size_t idx,
+           num_moves,
+           num_bad_captures;
+} move_picker_t;
 
-/* Private variable, use the gupta_get_search_time() and gupta_set_search_time() functions to
- * retrieve and change it.
+/* Prepares 'picker' to hand out the moves of the position of search 's' at game tree height
+ * 'height'. The hash move is only handed out if it is legal, that way an invalid move from a hash
+ * key collision can never be made. If 'captures_only' is set, only the captures and queen
+ * promotions that don't lose material are handed out.
  */
-static size_t search_time = GUPTA_SEARCH_TIME_DEFAULT;
+static void init_move_picker(const gupta_search_t *s, move_picker_t *picker,
+                             const move_t *hash_move, size_t height, int captures_only)
+{
+    size_t i;
+
+    picker->stage = captures_only ? STAGE_GEN_CAPTURES : STAGE_HASH_MOVE;
+    picker->captures_only = captures_only;
 
-static int abort_search;
+    picker->hash_move = PACKED_MOVE_NONE;
+    if (!captures_only && (hash_move->from != 0x88))
+        picker->hash_move = PACK_MOVE_T(*hash_move);
 
-static size_t interrupt_counter;
+    for (i = 0; i < NUM_KILLER_MOVES; i++)
+        picker->killer_moves[i] = captures_only ? PACKED_MOVE_NONE : s->killer_moves[height][i];
 
-static time_t time_search_begin;
+    picker->idx = 0;
+    picker->num_moves = 0;
+    picker->num_bad_captures = 0;
+}
 
-int is_search_time_exhausted()
+/* Selects the highest scoring move of the moves from 'picker->idx' up to 'picker->num_moves', and
+ * swaps it with the move at 'picker->idx'. Returns the selected move.
+ */
+static const scored_move_t *pick_best_move(move_picker_t *picker)
 {
-    struct timeval t;
-    int r;
+    scored_move_t *moves = picker->moves,
+                  best;
+    size_t best_idx = picker->idx,
+           i;
 
-    r = gettimeofday(&t, NULL);
-    UASSERT(r == 0);
-    (void)r;
+    for (i = picker->idx + 1; i < picker->num_moves; i++)
+    {
+        if (moves[i].score > moves[best_idx].score)
+            best_idx = i;
+    }
+
+    best = moves[best_idx];
+    moves[best_idx] = moves[picker->idx];
+    moves[picker->idx] = best;
+    return &moves[picker->idx];
+}
 
-    if (t.tv_sec < time_search_begin)
+/* Returns the next move of the position of search 's', and stores its move ordering score in
+ * 'score'. Returns PACKED_MOVE_NONE once all the moves were handed out. Every legal move is handed
+ * out exactly once, in the order of the stages of 'stage_t'.
+ */
+static packed_move_t next_move(const gupta_search_t *s, move_picker_t *picker, int *score)
+{
+    const gupta_position_t *pos = s->pos;
+    const scored_move_t *m;
+    size_t i;
+
+    switch (picker->stage)
     {
-        /* The clock was set back to earlier than when we started searching. We don't know how much
-         * time passed, so we can't re-adjust the time snapshot we took at the beginning of the
-         * search. Therefore, we simply say that the search time is exhausted.
+    case STAGE_HASH_MOVE:
+        picker->stage = STAGE_GEN_CAPTURES;
+        if ((picker->hash_move != PACKED_MOVE_NONE) &&
+            is_legal_move(pos, picker->hash_move, GEN_ALL))
+        {
+            *score = MOVE_SCORE_HASH_MOVE;
+            return picker->hash_move;
+        }
+        /* FALLTHROUGH */
+
+    case STAGE_GEN_CAPTURES:
+        picker->num_moves = gen_moves(pos, GEN_NOISY, picker->moves);
+        for (i = 0; i < picker->num_moves; i++)
+        {
+            move_t capture;
+
+            UNPACK_MOVE(capture, picker->moves[i].move);
+            picker->moves[i].score = score_capture(pos, &capture);
+        }
+        picker->stage = STAGE_GOOD_CAPTURES;
+        /* FALLTHROUGH */
+
+    case STAGE_GOOD_CAPTURES:
+        while (picker->idx < picker->num_moves)
+        {
+            m = pick_best_move(picker);
+            if (m->score < MOVE_SCORE_GOOD_CAPTURE)
+            {
+                /* All the remaining captures lose material. The captures that were handed out are
+                 * no longer needed, so the losing ones take their place.
+                 */
+                picker->num_bad_captures = picker->num_moves - picker->idx;
+                memmove(picker->moves, m, picker->num_bad_captures * sizeof(*m));
+                break;
+            }
+
+            picker->idx++;
+            if (m->move != picker->hash_move)
+            {
+                *score = m->score;
+                return m->move;
+            }
+        }
+
+        if (picker->captures_only)
+        {
+            picker->stage = STAGE_DONE;
+            return PACKED_MOVE_NONE;
+        }
+
+        picker->idx = 0;
+        picker->stage = STAGE_KILLERS;
+        /* FALLTHROUGH */
+
+    case STAGE_KILLERS:
+        /* A killer move comes from another position, so it's only handed out if it's legal (and
+         * non-capturing) in this one.
          */
+        while (picker->idx < NUM_KILLER_MOVES)
+        {
+            packed_move_t killer = picker->killer_moves[picker->idx++];
+
+            if ((killer != PACKED_MOVE_NONE) && (killer != picker->hash_move) &&
+                is_legal_move(pos, killer, GEN_QUIET))
+            {
+                /* The first killer move is the most recent one. */
+                *score = MOVE_SCORE_KILLER + (picker->idx == 1);
+                return killer;
+            }
+        }
+        picker->stage = STAGE_GEN_QUIETS;
+        /* FALLTHROUGH */
+
+    case STAGE_GEN_QUIETS:
+        picker->idx = picker->num_bad_captures;
+        picker->num_moves = picker->num_bad_captures +
+                            gen_moves(pos, GEN_QUIET, &picker->moves[picker->num_bad_captures]);
+        for (i = picker->idx; i < picker->num_moves; i++)
+        {
+            packed_move_t quiet = picker->moves[i].move;
+
+            picker->moves[i].score = MOVE_SCORE_QUIET +
+                s->history_scores[PACKED_MOVE_FROM(quiet)][PACKED_MOVE_TO(quiet)];
+        }
+        picker->stage = STAGE_QUIETS;
+        /* FALLTHROUGH */
+
+    case STAGE_QUIETS:
+        while (picker->idx < picker->num_moves)
+        {
+            m = pick_best_move(picker);
+            picker->idx++;
+            if ((m->move != picker->hash_move) && (m->move != picker->killer_moves[0]) &&
+                (m->move != picker->killer_moves[1]))
+            {
+                *score = m->score;
+                return m->move;
+            }
+        }
+
+        picker->idx = 0;
+        picker->num_moves = picker->num_bad_captures;
+        picker->stage = STAGE_BAD_CAPTURES;
+        /* FALLTHROUGH */
+
+    case STAGE_BAD_CAPTURES:
+        while (picker->idx < picker->num_moves)
+        {
+            m = pick_best_move(picker);
+            picker->idx++;
+            if (m->move != picker->hash_move)
+            {
+                *score = m->score;
+                return m->move;
+            }
+        }
+        picker->stage = STAGE_DONE;
+        /* FALLTHROUGH */
+
+    case STAGE_DONE:
+        break;
+    }
+
+    return PACKED_MOVE_NONE;
+}
+
+/* Returns whether the move captures a piece or promotes a pawn. Must be called before the move is
+ * made.
+ */
+static int is_capture_or_promotion(const gupta_position_t *pos, const move_t *m)
+{
+    if (pos->board[m->to] || (m->promote != PROMOTE_NONE))
         return 1;
+
+    /* En Passant. */
+    return (PIECE_TYPE(pos->board[m->from]) == PAWN) && ((m->to & 0x0F) != (m->from & 0x0F));
+}
+
+/* Remembers a non-capturing move that caused a beta cutoff, see 'killer_moves' and
+ * 'history_scores'.
+ */
+static void update_quiet_move_ordering(gupta_search_t *s, const move_t *m, int depth,
+                                       size_t height)
+{
+    packed_move_t pm = PACK_MOVE_T(*m);
+
+    if (pm != s->killer_moves[height][0])
+    {
+        s->killer_moves[height][1] = s->killer_moves[height][0];
+        s->killer_moves[height][0] = pm;
+    }
+
+    s->history_scores[m->from][m->to] += depth * depth;
+    if (s->history_scores[m->from][m->to] >= HISTORY_SCORE_MAX)
+    {
+        size_t from, to;
+
+        for (from = 0; from < ARRAY_SIZE(s->history_scores); from++)
+            for (to = 0; to < ARRAY_SIZE(s->history_scores[0]); to++)
+                s->history_scores[from][to] /= 2;
+    }
+}
+
+/* Called before every new search. The killer moves are tied to game tree heights, so after the
+ * game progressed, they belong to different positions and are thrown away. The history scores
+ * still apply, but the old ones shouldn't outweigh what the new search learns, so they are halved.
+ */
+static void age_move_ordering(gupta_search_t *s)
+{
+    size_t height,
+           i,
+           from,
+           to;
+
+    for (height = 0; height < ARRAY_SIZE(s->killer_moves); height++)
+        for (i = 0; i < NUM_KILLER_MOVES; i++)
+            s->killer_moves[height][i] = PACKED_MOVE_NONE;
+
+    for (from = 0; from < ARRAY_SIZE(s->history_scores); from++)
+        for (to = 0; to < ARRAY_SIZE(s->history_scores[0]); to++)
+            s->history_scores[from][to] /= 2;
+}
+
+/* Forgets all the killer moves and history scores, such as when a new game is started. */
+static void clear_move_ordering(gupta_search_t *s)
+{
+    size_t height,
+           i;
+
+    for (height = 0; height < ARRAY_SIZE(s->killer_moves); height++)
+        for (i = 0; i < NUM_KILLER_MOVES; i++)
+            s->killer_moves[height][i] = PACKED_MOVE_NONE;
+
+    memset(s->history_scores, 0, sizeof(s->history_scores));
+}
+
+/* Checkmate scores are relative to the root of the game tree, but in the transposition table they
+ * have to be stored relative to the position they were found for, as the position may be reached
+ * again at a different height.
+ */
+static int score_to_tt(int score, size_t height)
+{
+    if (score >= CHECKMATE_THRESHOLD)
+        return score + (int)height;
+    else if (score <= -CHECKMATE_THRESHOLD)
+        return score - (int)height;
+    return score;
+}
+
+static int score_from_tt(int score, size_t height)
+{
+    if (score >= CHECKMATE_THRESHOLD)
+        return score - (int)height;
+    else if (score <= -CHECKMATE_THRESHOLD)
+        return score + (int)height;
+    return score;
+}
+
+/* Converts the value of a position in the endgame tablebases (see 'tablebase.h') to a score. A
+ * checkmate beyond the maximum search depth can't be scored as a checkmate, so it gets a score
+ * just short of one, which still prefers the quicker wins.
+ */
+static int tablebase_score(unsigned int value, size_t height)
+{
+    int plies,
+        score;
+
+    if (value == 0)
+        return 0;
+
+    plies = (int)value - 1;
+    if (height + (size_t)plies < GUPTA_SEARCH_DEPTH_MAX)
+        score = SEARCH_INFINITY - (int)height - plies;
+    else
+        score = CHECKMATE_THRESHOLD - 1 - plies;
+
+    return TABLEBASE_IS_WIN(value) ? score : -score;
+}
+
+/* Returns the number of nodes searched so far by search 's' and its helpers. */
+static u64 count_all_nodes(const gupta_search_t *s)
+{
+    u64 nodes = s->search_nodes;
+    size_t i;
+
+    for (i = 0; i < s->num_helpers; i++)
+    {
+        if (s->helpers[i].is_running)
+            nodes += ATOMIC_LOAD(&s->helpers[i].search->search_nodes);
+    }
+
+    return nodes;
+}
+
+/* The principal variation ends wherever the search took a score from the transposition table, so
+ * for reporting it is extended with the hash moves that follow, up to the search depth.
+ */
+static void extend_line_from_tt(gupta_search_t *s, int depth, struct line *line)
+{
+    gupta_position_t *pos = s->pos;
+    tt_entry_t tt_entry;
+    int num_made;
+
+    for (num_made = 0; num_made < line->count; num_made++)
+    {
+        if (!make_move(pos, &line->moves[num_made], MOVE_NOSTRICT_VALIDATION))
+        {
+            UASSERT(0 && "The principal variation contains an illegal move.");
+            goto done;
+        }
+    }
+
+    while ((line->count < depth) && tt_probe(pos->hash_key, &tt_entry) &&
+           (tt_entry.move.from != 0x88) && make_move(pos, &tt_entry.move, MOVE_STRICT_VALIDATION))
+    {
+        line->moves[line->count++] = tt_entry.move;
+        num_made++;
     }
 
-    return (t.tv_sec - time_search_begin) >= (time_t)search_time;
+done:
+    while (num_made-- > 0)
+        gupta_undo_move(pos);
+}
+
+/* Passes the results of an iteration to the info callback, see gupta_search_info_t. */
+static void report_iteration(gupta_search_t *s, int depth, int score, const struct line *line)
+{
+    gupta_search_info_t info;
+    struct line pv = *line;
+
+    info.depth = (size_t)depth;
+    info.score = score;
+
+    /* A checkmate score is SEARCH_INFINITY minus the number of plies until checkmate. */
+    if (score >= CHECKMATE_THRESHOLD)
+        info.mate = (SEARCH_INFINITY - score + 1) / 2;
+    else if (score <= -CHECKMATE_THRESHOLD)
+        info.mate = -((SEARCH_INFINITY + score + 1) / 2);
+    else
+        info.mate = 0;
+
+    info.nodes = count_all_nodes(s);
+    info.time = get_elapsed_search_time(s);
+    extend_line_from_tt(s, depth, &pv);
+    info.pv = pv.moves;
+    info.pv_length = (size_t)pv.count;
+
+    s->report_info(s, &info);
+}
+
+/* Returns whether search 's' has to stop. This is polled at every node, and the flag may be set by
+ * another thread at any time, see gupta_abort_search().
+ */
+static int is_aborted(const gupta_search_t *s)
+{
+    return ATOMIC_LOAD(&s->abort_search);
+}
+
+/* Every X nodes, we check whether the search time is exhausted, and call the user-configurable
+ * interrupt function.
+ */
+static void count_node(gupta_search_t *s)
+{
+    /* Only this thread writes the node count, but the main search reads it, see
+     * count_all_nodes().
+     */
+    ATOMIC_STORE(&s->search_nodes, s->search_nodes + 1);
+    s->interrupt_counter++;
+
+    if (s->interrupt_counter == 10000)
+    {
+        s->interrupt_counter = 0;
+
+        /* The helpers of a search don't keep track of the time, they just stop once the main
+         * search does.
+         */
+        if (s->main)
+        {
+            if (ATOMIC_LOAD(&s->main->abort_search))
+                ATOMIC_STORE(&s->abort_search, 1);
+            return;
+        }
+
+        check_ponderhit(s);
+        if (is_hard_time_limit_reached(s))
+        {
+            /* Time's up. */
+            ATOMIC_STORE(&s->abort_search, 1);
+        }
+
+        if (s->interrupt)
+            s->interrupt(s);
+    }
+}
+
+/* The quiescence search is done at the horizon of the search, so that positions are never
+ * evaluated in the middle of a capture sequence (where for example a queen was just captured, but
+ * is about to be recaptured). Only capturing moves and queen promotions are searched, until the
+ * position is quiet.
+ * The side to move isn't obliged to capture, it may instead 'stand pat', accepting the static
+ * evaluation of the position. Hence the static evaluation is a lower bound of the score.
+ */
+static int quiesce(gupta_search_t *s, size_t height, int alpha, int beta)
+{
+    gupta_position_t *pos = s->pos;
+    move_picker_t picker;
+    move_t no_move;
+    packed_move_t pm;
+    int stand_pat,
+        move_score;
+
+    count_node(s);
+
+    if (is_aborted(s))
+        return alpha;
+
+    stand_pat = eval(pos);
+
+    /* The game tree may grow no higher, see GUPTA_SEARCH_DEPTH_MAX. */
+    if (height >= GUPTA_SEARCH_DEPTH_MAX)
+        return stand_pat;
+
+    if (stand_pat >= beta)
+        return stand_pat;
+    if (stand_pat > alpha)
+        alpha = stand_pat;
+
+    no_move.from = 0x88;
+
+    /* Only the captures and queen promotions that don't lose material are searched. */
+    init_move_picker(s, &picker, &no_move, height, 1);
+
+    while ((pm = next_move(s, &picker, &move_score)) != PACKED_MOVE_NONE)
+    {
+        move_t m;
+        int alpha_candidate;
+
+        /* The move generator only generates legal moves, so this can't fail. */
+        UNPACK_MOVE(m, pm);
+        (void)make_move(pos, &m, MOVE_NOSTRICT_VALIDATION);
+
+        alpha_candidate = -quiesce(s, height + 1, -beta, -alpha);
+
+        gupta_undo_move(pos);
+
+        if (is_aborted(s))
+            return alpha;
+
+        if (alpha_candidate > alpha)
+        {
+            alpha = alpha_candidate;
+
+            /* Beta cutoff, the opponent won't allow this position to be reached. */
+            if (alpha >= beta)
+                return alpha;
+        }
+    }
+
+    return alpha;
+}
+
+/* Returns whether 'side' has any pieces left besides its king and pawns. */
+static int has_non_pawn_material(const gupta_position_t *pos, int side)
+{
+    const u64 *pieces = pos->bitboards[side];
+
+    return (pieces[NOPIECE] & ~(pieces[PAWN] | pieces[KING])) != 0;
 }
 
 /* TODO
  * If no move found && in_check -> checkmate in the current search position.
  * If no move found && !in_check -> stalemate in the current search position.
  */
-int search(size_t height, int alpha, int beta, struct line *pline)
+int search(gupta_search_t *s, int depth, size_t height, int alpha, int beta, int allow_null_move,
+           struct line *pline)
 {
+    gupta_position_t *pos = s->pos;
     struct line line;
-    size_t range_idx = 0;
-    range_t move_stack_ranges[2]; /* Ranges for capturing and non-capturing moves. */
-    int no_valid_moves = 1;
+    move_picker_t picker;
+    packed_move_t pm;
+    size_t num_valid_moves = 0;
+    unsigned int tablebase_value;
+    int alpha_original = alpha,
+        bound,
+        in_check,
+        move_score;
+    tt_entry_t tt_entry;
+    move_t hash_move,
+           best_move;
 
     /* This way we're gently informed about stack overflows (which may occur if this function
      * recurses too much, which probably means that there is a bug).
@@ -95,240 +780,820 @@ int search(size_t height, int alpha, int beta, struct line *pline)
 
     line.count = 0;
 
-    if (height == 0)
+    /* At the horizon, only the capture sequences are resolved. */
+    if (depth <= 0)
+        return quiesce(s, height, alpha, beta);
+
+    count_node(s);
+
+    if (is_aborted(s))
+        return alpha;
+
+    if (is_draw_by_insufficient_material(pos))
+        return 0;
+
+    /* Either side may claim a draw by threefold repetition or by the fifty-move rule. Whichever
+     * side can do no better will, and a position that repeated once can be repeated again, so the
+     * first repetition already scores as a draw. At the top of the game tree a move is needed, so
+     * the search goes on there.
+     */
+    if ((height > 0) && (is_repetition(pos) || is_draw_by_fifty_move_rule(pos)))
+        return 0;
+
+    /* The endgame tablebases hold the exact scores of the positions with few pieces. At the top of
+     * the game tree a move is needed, so the search goes on there, but the scores of the moves are
+     * looked up right away.
+     */
+    if (s->use_tablebases && (height > 0) && tablebase_probe(pos, &tablebase_value))
+        return tablebase_score(tablebase_value, height);
+
+    hash_move.from = 0x88;
+    if (tt_probe(pos->hash_key, &tt_entry))
     {
-        /* The search starts. */
-        interrupt_counter = 0;
+        hash_move = tt_entry.move;
 
-        snap_search_start_time();
+        /* At the top of the game tree we need a move, not just a score, so we always search
+         * there.
+         */
+        if ((height > 0) && (tt_entry.depth >= depth))
+        {
+            int score = score_from_tt(tt_entry.score, height);
+
+            if (tt_entry.bound == TT_BOUND_EXACT)
+                return score;
+            else if ((tt_entry.bound == TT_BOUND_LOWER) && (score >= beta))
+                return score;
+            else if ((tt_entry.bound == TT_BOUND_UPPER) && (score <= alpha))
+                return score;
+        }
     }
-    else
-        interrupt_counter++;
 
-    /* Every X nodes, we check whether the search time is exhausted, and call the
-     * user-configurable interrupt function (which one can use to process input).
+    in_check = is_king_in_check(pos, pos->tside);
+
+    /* Null move pruning: if the side to move can pass its turn, and a reduced depth search still
+     * shows that its position is too good for the opponent to allow (that is, the score is at
+     * least 'beta'), then actually making a move will most likely only improve the position, so
+     * the search of this node is cut short.
+     * Passing isn't legal when in check, and in the endgame (here: only pawns left) being forced to
+     * move may well be a disadvantage (zugzwang), so then the null move proves nothing. Neither
+     * is a null move made at the top of the game tree, in nodes with an open window (as those are
+     * the nodes whose score matters exactly), or twice in a row.
+     * When enough depth remains, the cutoff is verified by a reduced depth search of this node
+     * without a null move, to avoid being fooled by zugzwang in other positions.
      */
-    if (interrupt_counter == 10000)
+    if (allow_null_move && SEARCH_PARAM(SEARCH_PARAM_NULL_MOVE) && (height > 0) &&
+        (depth >= 2) && (beta - alpha == 1) && (beta < CHECKMATE_THRESHOLD) &&
+        (beta > -CHECKMATE_THRESHOLD) && !in_check && has_non_pawn_material(pos, pos->tside))
     {
-        interrupt_counter = 0;
+        int reduced_depth = depth - 1 - SEARCH_PARAM(SEARCH_PARAM_NULL_MOVE_REDUCTION),
+            verification_depth = SEARCH_PARAM(SEARCH_PARAM_NULL_MOVE_VERIFICATION_DEPTH),
+            null_move_score;
+
+        make_null_move(pos);
+        null_move_score = -search(s, reduced_depth, height + 1, -beta, -beta + 1, 0, &line);
+        undo_null_move(pos);
+
+        if (is_aborted(s))
+            return alpha;
 
-        if (is_search_time_exhausted())
+        if (null_move_score >= beta)
         {
-            /* Time's up. */
-            abort_search = 1;
+            if ((verification_depth == 0) || (depth < verification_depth))
+                return beta;
+
+            if (search(s, reduced_depth, height, alpha, beta, 0, &line) >= beta)
+                return beta;
+
+            if (is_aborted(s))
+                return alpha;
         }
 
-        g_search_interrupt();
+        line.count = 0;
     }
 
-    if (abort_search)
-        return alpha;
+    init_move_picker(s, &picker, &hash_move, height, 0);
 
-    /* Using '>=' instead of '==', because the search depth may be changed while the search
-     * algorithm is running.
+    /* The best move is stored in the transposition table even if there is none, so all of its
+     * members are set.
      */
-    if (height >= search_depth)
-        return eval();
-
-    if (is_draw_by_insufficient_material())
-        return 0;
+    best_move.from = 0x88;
+    best_move.to = 0x88;
+    best_move.promote = PROMOTE_NONE;
 
-    /* TODO XXX
-     * Check for draws that may be forcefully _claimed_, such as threefold repetition draws and
-     * draws by the 50-move rule.
-     */
+    while ((pm = next_move(s, &picker, &move_score)) != PACKED_MOVE_NONE)
+    {
+        move_t m;
+        int alpha_candidate,
+            is_quiet;
 
-    gen_moves(height, move_stack_ranges);
+        UNPACK_MOVE(m, pm);
 
-    for (range_idx = 0; range_idx < ARRAY_SIZE(move_stack_ranges); range_idx++)
-    {
-        size_t idx;
-        range_t *range = &move_stack_ranges[range_idx];
+        is_quiet = !is_capture_or_promotion(pos, &m);
 
-        for (idx = range->begin; idx < range->end; idx++)
-        {
-            int alpha_candidate;
+        (void)make_move(pos, &m, MOVE_NOSTRICT_VALIDATION);
 
-            if (!make_move(&g_move_stack[idx], MOVE_NOSTRICT_VALIDATION))
-                continue;
+        num_valid_moves++;
 
-            no_valid_moves = 0;
+        /* The search of the position after the move only fills in its principal variation if
+         * it finds a move that raises alpha, so the variation of the previous move mustn't be
+         * left over.
+         */
+        line.count = 0;
 
 /* If using '#if 1' here, alpha-beta pruning is effectively disabled for a specific move, making it
  * possible to reliably capture its move line (even if it would normally be discarded by alpha-beta
  * pruning).
  */
 #if 0
-            if ((height == 0) && (strcmp(gupta_move_to_can(&g_move_stack[idx]), "f2f1q") == 0))
-            {
-                int q;
+        if ((height == 0) && (strcmp(gupta_move_to_can(&m), "f2f1q") == 0))
+        {
+            int q;
 
-                alpha_candidate = -search(height + 1, -beta, +SEARCH_INFINITY, &line);
+            alpha_candidate = -search(s, depth - 1, height + 1, -beta, +SEARCH_INFINITY, 1, &line);
 
-                /* Prepending '<>' so that the output won't be interpreted by the chess interface as a
-                 * CECP 'move' command.
-                 */
-                printf("<> move %s got score %d\n", gupta_move_to_can(&g_move_stack[idx]), alpha_candidate);
-                printf("   its line was:\n");
-                for (q = 0; q < line.count; q++)
-                    printf("   %d: %s (%d)\n", q, line.moves[q], line.alphas[q]);
-            }
-            else
+            /* Prepending '<>' so that the output won't be interpreted by the chess interface as a
+             * CECP 'move' command.
+             */
+            printf("<> move %s got score %d\n", gupta_move_to_can(&m),
+                   alpha_candidate);
+            printf("   its line was:\n");
+            for (q = 0; q < line.count; q++)
+                printf("   %d: %s\n", q, gupta_move_to_can(&line.moves[q]));
+        }
+        else
 #endif
+        if (num_valid_moves == 1)
+            alpha_candidate = -search(s, depth - 1, height + 1, -beta, -alpha, 1, &line);
+        else
+        {
+            int reduction = 0;
+
+            /* Late move reductions: with good move ordering, the quiet moves late in the list are
+             * unlikely to be any good, so they are searched with a reduced depth. Moves that check
+             * or evade a check, killer moves, and moves near the horizon are never reduced.
+             */
+            if (SEARCH_PARAM(SEARCH_PARAM_LMR) && is_quiet && !in_check &&
+                (depth >= SEARCH_PARAM(SEARCH_PARAM_LMR_MIN_DEPTH)) &&
+                (num_valid_moves > (size_t)SEARCH_PARAM(SEARCH_PARAM_LMR_FULL_DEPTH_MOVES)) &&
+                (move_score < MOVE_SCORE_KILLER) && !is_king_in_check(pos, pos->tside))
             {
-                alpha_candidate = -search(height + 1, -beta, -alpha, &line);
+                reduction = SEARCH_PARAM(SEARCH_PARAM_LMR_REDUCTION);
             }
 
-            gupta_undo_move();
+            /* Principal variation search: with good move ordering, the first move is the best move
+             * most of the time. The other moves are therefore searched with a null window, which
+             * is cheaper, as it only proves that they aren't better. Only if that proof fails is
+             * the move searched again with the full window, to get its actual score.
+             * A reduced move that turns out to be better is first searched again at full depth.
+             */
+            alpha_candidate = -search(s, depth - 1 - reduction, height + 1, -alpha - 1, -alpha, 1,
+                                      &line);
+            if (!is_aborted(s) && reduction && (alpha_candidate > alpha))
+                alpha_candidate = -search(s, depth - 1, height + 1, -alpha - 1, -alpha, 1, &line);
+            if (!is_aborted(s) && (alpha_candidate > alpha) && (alpha_candidate < beta))
+                alpha_candidate = -search(s, depth - 1, height + 1, -beta, -alpha, 1, &line);
+        }
 
-            if (beta <= alpha)
-                break;
+        gupta_undo_move(pos);
 
-            if (alpha_candidate > alpha)
-            {
-                alpha = alpha_candidate;
+        if (is_aborted(s))
+        {
+            /* If the search should be aborted but no best move was yet selected, just select
+             * the current move.
+             */
+            if ((height == 0) && (s->root_best_move.from == 0x88))
+                s->root_best_move = m;
+            return alpha;
+        }
 
-                /* If we're at the top of the game tree, we should keep track of which move is the
-                 * best.
-                 */
-                if (height == 0)
-                    g_best_move_idx = idx;
-
-                /* TODO XXX remove */
-                strcpy(pline->moves[0], gupta_move_to_can(&g_move_stack[idx]));
-                pline->alphas[0] = alpha_candidate;
-                UASSERT(sizeof(pline->moves) >= (line.count + 1) * sizeof(line.moves[0]));
-                memcpy(&pline->moves[1], line.moves, line.count * sizeof(line.moves[0]));
-                UASSERT(sizeof(pline->alphas) >= (line.count + 1) * sizeof(line.alphas[0]));
-                memcpy(&pline->alphas[1], line.alphas, line.count * sizeof(line.alphas[0]));
-                pline->count = line.count + 1;
-            }
+        if (alpha_candidate > alpha)
+        {
+            alpha = alpha_candidate;
+            best_move = m;
 
-            if (abort_search)
-            {
-                /* If the search should be aborted but no best move was yet selected, just select
-                 * the current move.
-                 */
-                if ((height == 0) && (g_best_move_idx == (size_t)-1))
-                    g_best_move_idx = idx;
-                return alpha;
-            }
+            /* If we're at the top of the game tree, we should keep track of which move is the
+             * best.
+             */
+            if (height == 0)
+                s->root_best_move = m;
+
+            /* The principal variation of this position is this move, followed by the principal
+             * variation of the position after it.
+             */
+            pline->moves[0] = m;
+            UASSERT(sizeof(pline->moves) >= (line.count + 1) * sizeof(line.moves[0]));
+            memcpy(&pline->moves[1], line.moves, line.count * sizeof(line.moves[0]));
+            pline->count = line.count + 1;
+
+            /* A new best move at the top of the game tree changes the principal variation of
+             * the iteration, which is reported right away, rather than once the iteration is done
+             * (which may take long).
+             */
+            if ((height == 0) && (num_valid_moves > 1) && (alpha < beta) && s->report_info)
+                report_iteration(s, depth, alpha, pline);
+        }
+
+        /* Beta cutoff, the opponent won't allow this position to be reached. */
+        if (alpha >= beta)
+        {
+            if (is_quiet)
+                update_quiet_move_ordering(s, &m, depth, height);
+            break;
         }
     }
 
-    if (no_valid_moves)
+    if (num_valid_moves == 0)
     {
-        if (is_king_in_check(g_tside))
+        if (is_king_in_check(pos, pos->tside))
         {
-            /* TODO XXX
-             * With iterative deepening, would we still need to subtract 'height' ?
-             * To understand the question, picture what would happen without iterative deepening.
-             * Without iterative deepening, it might be that we descend into a path of 3 moves
-             * deep, which results in a checkmate. All nice and well, but we later on find a node
-             * that was 2 moves deep that results in a checkmate. Thus, we have to subtract 'height'
-             * to make sure that when we return, 'alpha_candidate > alpha'.
-             * But now, picture it with iterative deepening, we never reach a node of 3 moves
-             * deep AND then a node of 2 moves deep, so the shortest path is always searched first.
-             * Hence, no need to subtract 'height' with iterative deepening?
-             * > Update, if it turns out that indeed subtracting the height becomes superfluous
-             *   once we do iterative deepening, then change the '#define RESIGNATION_THRESHOLD'
-             *   so that it does not subtract the maximum game tree height either.
+            /* The lower the game tree height, the better, as it leads to quicker mating.
+             * Iterative deepening alone doesn't make subtracting 'height' superfluous: a checkmate
+             * found by a deeper iteration may still be preferred over a quicker one if both were
+             * scored alike, and the transposition table carries checkmates found at one height
+             * over to other heights.
              */
-
-            /* The lower the game tree height, the better, as it leads to quicker mating. */
             alpha = -(SEARCH_INFINITY - height); /* Checkmate. */
         }
         else
             alpha = 0; /* Draw by stalemate. */
+
+        bound = TT_BOUND_EXACT;
     }
+    else if (alpha >= beta)
+        bound = TT_BOUND_LOWER;
+    else if (alpha > alpha_original)
+        bound = TT_BOUND_EXACT;
+    else
+        bound = TT_BOUND_UPPER;
+
+    tt_store(pos->hash_key, depth, bound, score_to_tt(alpha, height), &best_move,
+             s->tt_generation);
+
+    if (height == 0)
+        s->num_root_moves = num_valid_moves;
 
     return alpha;
 }
 
-/* Take a snapshot of the time, marking the start of the search. */
-void snap_search_start_time()
+static void destroy_helpers(gupta_search_t *s)
+{
+    size_t i;
+
+    for (i = 0; i < s->num_helpers; i++)
+    {
+        UASSERT(!s->helpers[i].is_running);
+        gupta_destroy_search(s->helpers[i].search);
+        gupta_destroy_position(s->helpers[i].pos);
+    }
+
+    free(s->helpers);
+    s->helpers = NULL;
+    s->num_helpers = 0;
+}
+
+gupta_search_t *gupta_create_search()
 {
-    struct timeval t;
-    int r;
+    gupta_search_t *s = calloc(1, sizeof(*s));
 
-    r = gettimeofday(&t, NULL);
-    UASSERT(r == 0);
-    (void)r;
+    if (!s)
+        enforce(0 && "out of memory");
 
-    time_search_begin = t.tv_sec;
+    s->search_depth = GUPTA_SEARCH_DEPTH_MAX;
+    s->search_time = GUPTA_SEARCH_TIME_DEFAULT;
+    s->use_book = 1;
+    /* Any seed but 0 will do, as long as it differs between runs, so that the games do too. */
+    s->random_state = (timer_get_ms() + 1) * 0x9E3779B97F4A7C15ULL;
+    s->use_tablebases = 1;
+    gupta_clear_search(s);
+
+    return s;
 }
 
-void gupta_abort_search()
+void gupta_destroy_search(gupta_search_t *s)
 {
-    abort_search = 1;
+    destroy_helpers(s);
+    free(s);
 }
 
-void gupta_find_move()
+/* Forgets what earlier searches learned, such as when a new game is started. The search limits,
+ * the number of threads, and the interrupt callback are kept.
+ */
+void gupta_clear_search(gupta_search_t *s)
 {
-    struct line line; /* TODO remove */
+    size_t i;
 
-    line.count = 0;
+    s->best_move.from = 0x88;
+    s->is_resignation_sensible = 0;
+    clear_move_ordering(s);
+
+    for (i = 0; i < s->num_helpers; i++)
+        gupta_clear_search(s->helpers[i].search);
+}
+
+/* Stops the search as soon as possible. May be called from any thread, for example from another
+ * thread than the one searching, or from the interrupt callback.
+ */
+void gupta_abort_search(gupta_search_t *s)
+{
+    ATOMIC_STORE(&s->abort_search, 1);
+}
+
+/* The initial half-width of the aspiration windows, see iterative_deepening(). Windows that grow
+ * beyond ASPIRATION_WINDOW_MAX are opened up entirely.
+ */
+#define ASPIRATION_WINDOW     50
+#define ASPIRATION_WINDOW_MAX 1000
+
+/* Prepares search 's' for searching position 'pos'. */
+static void start_search(gupta_search_t *s, gupta_position_t *pos)
+{
+    s->pos = pos;
+    ATOMIC_STORE(&s->abort_search, 0);
+    s->search_nodes = 0;
+    s->interrupt_counter = 0;
+    s->search_start_time = timer_get_ms();
+    s->awaits_ponderhit = ATOMIC_LOAD(&s->is_pondering);
+    allocate_time(s);
+    s->num_root_moves = 0;
+    s->best_move.from = 0x88;
+    s->ponder_move.from = 0x88;
+    age_move_ordering(s);
+}
+
+/* The game tree is searched with iterative deepening: the search is repeated with a search depth
+ * of 1, 2, 3, and so on, until either the maximum search depth or the soft time limit is reached.
+ * Each iteration fills the transposition table with the best moves found, so the next iteration
+ * searches those first, which more than makes up for the repeated work.
+ * If the hard time limit is reached, the iteration in progress is thrown away, and the best move
+ * of the last completed iteration is used.
+ * Returns the score of the last completed iteration.
+ */
+static int iterative_deepening(gupta_search_t *s)
+{
+    struct line line;
+    int first_depth,
+        depth,
+        score = 0;
+    size_t num_stable_iterations = 0;
+
+    /* Every other helper searches one ply deeper than the main search, so that the threads
+     * don't all search the same tree at the same time.
+     */
+    first_depth = 1 + (int)(s->helper_idx % 2);
+
+    /* The search depth is reread for every iteration, because it may be changed while the search
+     * algorithm is running.
+     */
+    for (depth = first_depth; depth <= (int)s->search_depth; depth++)
+    {
+        int iteration_score,
+            alpha = -SEARCH_INFINITY,
+            beta = +SEARCH_INFINITY,
+            window = ASPIRATION_WINDOW,
+            has_failed_low = 0;
+
+        /* Aspiration window: the score of this iteration most likely won't differ much from the
+         * score of the previous iteration, so the search is started with a narrow window around
+         * that score, which causes more cutoffs. If the score falls outside the window after all,
+         * the search is repeated with the failing side of the window widened.
+         */
+        if ((depth > first_depth) && (abs(score) < CHECKMATE_THRESHOLD))
+        {
+            alpha = score - window;
+            beta = score + window;
+        }
 
-    UASSERT(g_search_interrupt && "search interrupt callback needs to be set prior to calling search()");
+        for (;;)
+        {
+            line.count = 0;
+            s->root_best_move.from = 0x88;
+
+            iteration_score = search(s, depth, 0, alpha, beta, 1, &line);
+
+            if (is_aborted(s))
+                break;
+
+            window *= 4;
+            if ((iteration_score <= alpha) && (alpha > -SEARCH_INFINITY))
+            {
+                alpha = (window > ASPIRATION_WINDOW_MAX) ? -SEARCH_INFINITY : score - window;
+                has_failed_low = 1;
+            }
+            else if ((iteration_score >= beta) && (beta < +SEARCH_INFINITY))
+                beta = (window > ASPIRATION_WINDOW_MAX) ? +SEARCH_INFINITY : score + window;
+            else
+                break;
+        }
+
+        if (is_aborted(s))
+        {
+            /* If not even the first iteration was completed, we have no choice but to use the
+             * move selected by the interrupted iteration.
+             */
+            if (s->best_move.from == 0x88)
+                s->best_move = s->root_best_move;
+            break;
+        }
+
+        if ((depth > first_depth) && (iteration_score < score - FAIL_LOW_MARGIN))
+            has_failed_low = 1;
+
+        if ((depth > first_depth) && MOVES_ARE_EQUAL(s->best_move, s->root_best_move))
+            num_stable_iterations++;
+        else
+            num_stable_iterations = 0;
+
+        s->best_move = s->root_best_move;
+        score = iteration_score;
+
+        /* The principal variation starts with the best move, followed by the expected reply. */
+        if (line.count > 1)
+            s->ponder_move = line.moves[1];
+        else
+            s->ponder_move.from = 0x88;
+
+        if (s->report_info)
+            report_iteration(s, depth, score, &line);
+
+        /* A checkmate within the search depth can't be improved upon by searching deeper. */
+        if ((score >= CHECKMATE_THRESHOLD || score <= -CHECKMATE_THRESHOLD) &&
+            (SEARCH_INFINITY - abs(score) <= depth))
+            break;
+
+        check_ponderhit(s);
+        adjust_time_limit(s, has_failed_low, num_stable_iterations);
+        if (is_soft_time_limit_reached(s))
+            break;
+    }
 
-    abort_search = 0;
-    g_best_move_idx = -1;
-    if (search(0, -SEARCH_INFINITY, +SEARCH_INFINITY, &line) <= RESIGNATION_THRESHOLD)
-        g_is_resignation_sensible = 1;
+    return score;
+}
+
+/* The principal variation of the last iteration may have been cut short, for example by a hash
+ * table cutoff, so that it doesn't contain the expected reply to the best move. In that case the
+ * reply is taken from the transposition table instead.
+ */
+static void find_ponder_move(gupta_search_t *s, gupta_position_t *pos)
+{
+    tt_entry_t tt_entry;
+
+    if ((s->best_move.from == 0x88) || (s->ponder_move.from != 0x88))
+        return;
+
+    if (!make_move(pos, &s->best_move, MOVE_NOSTRICT_VALIDATION))
+        return;
+
+    if (tt_probe(pos->hash_key, &tt_entry) && (tt_entry.move.from != 0x88) &&
+        make_move(pos, &tt_entry.move, MOVE_STRICT_VALIDATION))
+    {
+        s->ponder_move = tt_entry.move;
+        gupta_undo_move(pos);
+    }
+
+    gupta_undo_move(pos);
+}
+
+/* A xorshift64 generator, see 'random_state'. */
+static u64 next_random(gupta_search_t *s)
+{
+    s->random_state ^= s->random_state << 13;
+    s->random_state ^= s->random_state >> 7;
+    s->random_state ^= s->random_state << 17;
+    return s->random_state;
+}
+
+static void helper_thread(void *arg)
+{
+    (void)iterative_deepening(arg);
+}
+
+/* Searches the game tree of position 'pos', which is left unchanged once the search returns. The
+ * best move can then be retrieved with gupta_get_best_move(). If the position is in the opening
+ * book (see 'book.c') or in the endgame tablebases (see 'tablebase.c'), the move is taken from
+ * there instead.
+ * When the search uses more than one thread (see gupta_set_search_threads()), it is a Lazy SMP
+ * search: the helper threads search the same position as the calling thread, each on its own copy
+ * of it, without any coordination other than sharing the transposition table. That still makes
+ * the search deeper, as the helpers store results that the calling thread would otherwise have to
+ * find itself. Only the calling thread keeps track of the time and picks the move; once it is done,
+ * the helpers are stopped.
+ */
+void gupta_find_move(gupta_search_t *s, gupta_position_t *pos)
+{
+    size_t i;
+    unsigned int tablebase_value;
+    int score;
+
+    s->tt_generation = tt_begin_search();
+    start_search(s, pos);
+
+    /* A move of the opening book is played right away, except while pondering or analyzing, as
+     * those are about searching the position.
+     */
+    if (s->use_book && !ATOMIC_LOAD(&s->is_pondering) &&
+        book_probe(pos, next_random(s), &s->best_move))
+    {
+        score = 0;
+        goto done;
+    }
+
+    /* Likewise, in a position of the endgame tablebases, the move that leads to the best outcome
+     * is played right away.
+     */
+    if (s->use_tablebases && !ATOMIC_LOAD(&s->is_pondering) &&
+        tablebase_probe_root(pos, &s->best_move, &tablebase_value))
+    {
+        score = tablebase_score(tablebase_value, 0);
+        if (s->report_info)
+        {
+            struct line line;
+
+            line.count = 1;
+            line.moves[0] = s->best_move;
+            report_iteration(s, 1, score, &line);
+        }
+        goto done;
+    }
+
+    for (i = 0; i < s->num_helpers; i++)
+    {
+        search_helper_t *helper = &s->helpers[i];
+
+        copy_position(helper->pos, pos);
+        helper->search->search_depth = s->search_depth;
+        helper->search->use_tablebases = s->use_tablebases;
+        helper->search->tt_generation = s->tt_generation;
+        start_search(helper->search, helper->pos);
+
+        /* If a thread can't be started, the search just uses fewer threads. */
+        helper->is_running = thread_create(&helper->thread, helper_thread, helper->search);
+    }
+
+    score = iterative_deepening(s);
+
+    gupta_abort_search(s);
+    for (i = 0; i < s->num_helpers; i++)
+    {
+        search_helper_t *helper = &s->helpers[i];
+
+        if (!helper->is_running)
+            continue;
+
+        thread_join(&helper->thread);
+        helper->is_running = 0;
+        s->search_nodes += helper->search->search_nodes;
+    }
+
+done:
+    if (score <= RESIGNATION_THRESHOLD)
+        s->is_resignation_sensible = 1;
     else
     {
         /* It may be that we previously thought resignation was sensible, and that it isn't anymore
          * (due to imperfect play by the opponent).
          */
-        g_is_resignation_sensible = 0;
+        s->is_resignation_sensible = 0;
     }
 
-    /* TODO remove */
-    {
-        int j;
-        for (j = 0; j < line.count; j++)
-            printf("line move %d = %s (%d)\n", j, line.moves[j], line.alphas[j]);
-    }
+    /* Pondering only ever applies to a single search. */
+    ATOMIC_STORE(&s->is_pondering, 0);
+
+    find_ponder_move(s, pos);
+
+    tt_end_search();
+
+    if (s->report_best_move && (s->best_move.from != 0x88))
+        s->report_best_move(s, &s->best_move);
+}
+
+const move_t *gupta_get_best_move(const gupta_search_t *s)
+{
+    UASSERT((s->best_move.from != 0x88) && "no move was found");
+    return &s->best_move;
+}
+
+/* Returns the reply to the best move that the last search expects, which is the move to ponder on
+ * (see gupta_set_search_pondering()), or NULL if the search doesn't expect any reply.
+ */
+const move_t *gupta_get_ponder_move(const gupta_search_t *s)
+{
+    if (s->ponder_move.from == 0x88)
+        return NULL;
+
+    return &s->ponder_move;
+}
+
+size_t gupta_get_num_search_params()
+{
+    return ARRAY_SIZE(search_params);
+}
+
+const gupta_search_param_t *gupta_get_search_param(size_t idx)
+{
+    UASSERT(idx < ARRAY_SIZE(search_params));
+    return &search_params[idx];
+}
+
+u64 gupta_get_search_nodes(const gupta_search_t *s)
+{
+    return s->search_nodes;
+}
+
+void *gupta_get_search_user_data(const gupta_search_t *s)
+{
+    return s->user_data;
+}
+
+size_t gupta_get_search_depth(const gupta_search_t *s)
+{
+    return s->search_depth;
 }
 
-size_t gupta_get_search_depth()
+size_t gupta_get_search_threads(const gupta_search_t *s)
 {
-    return search_depth;
+    return s->num_helpers + 1;
 }
 
-size_t gupta_get_search_time()
+size_t gupta_get_search_time(const gupta_search_t *s)
 {
-    return search_time;
+    return s->search_time;
 }
 
-int gupta_is_resignation_sensible()
+int gupta_get_search_book(const gupta_search_t *s)
 {
-    return g_is_resignation_sensible;
+    return s->use_book;
 }
 
-void gupta_set_search_depth(size_t new_search_depth)
+int gupta_get_search_tablebases(const gupta_search_t *s)
+{
+    return s->use_tablebases;
+}
+
+int gupta_is_resignation_sensible(const gupta_search_t *s)
+{
+    return s->is_resignation_sensible;
+}
+
+void gupta_set_search_depth(gupta_search_t *s, size_t new_search_depth)
 {
     if ((new_search_depth == 0) || (new_search_depth > GUPTA_SEARCH_DEPTH_MAX))
     {
         /* The requested search depth was too high or infinite (denoted by a value of 0), so the
          * search depth should be clamped to the maximum search depth.
          */
-        search_depth = GUPTA_SEARCH_DEPTH_MAX;
+        s->search_depth = GUPTA_SEARCH_DEPTH_MAX;
     }
     else
-        search_depth = new_search_depth;
+        s->search_depth = new_search_depth;
+}
+
+/* Sets whether the search plays the moves of the opening book, see gupta_open_book(). It does by
+ * default.
+ */
+void gupta_set_search_book(gupta_search_t *s, int use_book)
+{
+    s->use_book = use_book != 0;
+}
+
+/* Sets whether the search looks positions up in the endgame tablebases, see
+ * gupta_open_tablebases(). It does by default.
+ */
+void gupta_set_search_tablebases(gupta_search_t *s, int use_tablebases)
+{
+    s->use_tablebases = use_tablebases != 0;
+}
+
+void gupta_set_search_best_move_cb(gupta_search_t *s, gupta_cb_search_best_move_t cb)
+{
+    s->report_best_move = cb;
+}
+
+void gupta_set_search_info_cb(gupta_search_t *s, gupta_cb_search_info_t cb)
+{
+    s->report_info = cb;
+}
+
+void gupta_set_search_interrupt(gupta_search_t *s, gupta_cb_search_interrupt_t cb)
+{
+    s->interrupt = cb;
+}
+
+/* Makes the next call to gupta_find_move() ponder: search the position (normally the position after
+ * the expected reply of the opponent) without regard to the search time, until the search is
+ * aborted or gupta_ponderhit() is called. An analysis, which searches until it is aborted, is
+ * pondering without a ponder hit.
+ */
+void gupta_set_search_pondering(gupta_search_t *s, int pondering)
+{
+    ATOMIC_STORE(&s->is_pondering, pondering != 0);
 }
 
-void gupta_set_search_interrupt(gupta_cb_search_interrupt_t cb)
+/* Turns a pondering search into a normal one, because the opponent played the expected move. The
+ * search time counts from the start of the pondering, so the time spent pondering isn't lost. The
+ * time limits are set again from the clock as it is now, see check_ponderhit(), so the clock should
+ * be brought up to date with gupta_set_search_clock() first. May be called from any thread.
+ */
+void gupta_ponderhit(gupta_search_t *s)
 {
-    UASSERT(cb != NULL);
-    g_search_interrupt = cb;
+    ATOMIC_STORE_RELEASE(&s->is_pondering, 0);
 }
 
-void gupta_set_search_time(size_t new_search_time)
+/* Sets the search parameter named 'name'. Returns 0 if there is no such parameter, if 'value' is
+ * out of its range, or if a search is running.
+ */
+int gupta_set_search_param(const char *name, int value)
 {
+    size_t idx;
+    int r = 0;
+
+    if (!tt_lock_if_idle())
+        return 0;
+
+    for (idx = 0; idx < ARRAY_SIZE(search_params); idx++)
+    {
+        gupta_search_param_t *param = &search_params[idx];
+
+        if (strcmp(param->name, name) != 0)
+            continue;
+
+        if ((value >= param->min) && (value <= param->max))
+        {
+            param->value = value;
+            r = 1;
+        }
+        break;
+    }
+
+    tt_unlock();
+    return r;
+}
+
+/* Sets the number of threads that gupta_find_move() uses, including the calling thread. The
+ * number is clamped to the range 1 to GUPTA_SEARCH_THREADS_MAX.
+ */
+void gupta_set_search_threads(gupta_search_t *s, size_t new_search_threads)
+{
+    size_t i;
+
+    if (new_search_threads == 0)
+        new_search_threads = 1;
+    else if (new_search_threads > GUPTA_SEARCH_THREADS_MAX)
+        new_search_threads = GUPTA_SEARCH_THREADS_MAX;
+
+    if (new_search_threads == s->num_helpers + 1)
+        return;
+
+    destroy_helpers(s);
+
+    s->helpers = calloc(new_search_threads - 1, sizeof(*s->helpers));
+    if (!s->helpers && (new_search_threads > 1))
+        enforce(0 && "out of memory");
+    s->num_helpers = new_search_threads - 1;
+
+    for (i = 0; i < s->num_helpers; i++)
+    {
+        search_helper_t *helper = &s->helpers[i];
+
+        helper->search = gupta_create_search();
+        helper->search->main = s;
+        helper->search->helper_idx = i + 1;
+        helper->search->search_time = GUPTA_SEARCH_TIME_INFINITE;
+        helper->pos = gupta_create_position();
+    }
+}
+
+/* Makes the searches budget their time from the clock of the side to move, see allocate_time(),
+ * until gupta_set_search_time() is called. 'time_left' is the time on the clock and 'increment'
+ * the time added to it after every move, both in milliseconds. 'moves_to_go' is the number of
+ * moves until the next time control, including the move to be searched, or 0 if the time has to
+ * last for the rest of the game.
+ * May also be called while the search is pondering, from any thread, to update the clock before
+ * gupta_ponderhit() is called.
+ */
+void gupta_set_search_clock(gupta_search_t *s, size_t time_left, size_t increment,
+                            size_t moves_to_go)
+{
+    ATOMIC_STORE(&s->use_clock, 1);
+    s->clock_time = time_left;
+    s->clock_increment = increment;
+    s->clock_moves_to_go = moves_to_go;
+}
+
+/* Sets the time that every search takes at most, in milliseconds, or the default search time if
+ * 'new_search_time' is 0.
+ */
+void gupta_set_search_time(gupta_search_t *s, size_t new_search_time)
+{
+    ATOMIC_STORE(&s->use_clock, 0);
+
     if (new_search_time == 0)
-        search_time = GUPTA_SEARCH_TIME_DEFAULT;
+        s->search_time = GUPTA_SEARCH_TIME_DEFAULT;
     else
-        search_time = new_search_time;
+        s->search_time = new_search_time;
+}
+
+/* Associates arbitrary data with search 's', for use by its callbacks. */
+void gupta_set_search_user_data(gupta_search_t *s, void *user_data)
+{
+    s->user_data = user_data;
 }
@@ -14,28 +14,157 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include "move.h"
 #include "search_public.h"
+#include "thread.h"
 
 #include <stddef.h>
 
 #define SEARCH_INFINITY 99999
 
-extern gupta_cb_search_interrupt_t g_search_interrupt;
-extern size_t                      g_best_move_idx;
+/* The killer moves are, for every game tree height, the last two non-capturing moves that caused a
+ * beta cutoff. A move that refutes one position often refutes its sibling positions as well.
+ */
+#define NUM_KILLER_MOVES 2
 
-extern int g_is_resignation_sensible;
+/* A helper thread of a Lazy SMP search, see gupta_find_move(). Each helper has its own search and
+ * its own copy of the position being searched.
+ */
+typedef struct
+{
+    thread_t         thread;
+    int              is_running;
+    gupta_search_t   *search;
+    gupta_position_t *pos;
+} search_helper_t;
+
+struct gupta_search
+{
+    /* The position being searched, only valid during gupta_find_move(). */
+    gupta_position_t *pos;
+
+    gupta_cb_search_interrupt_t interrupt;
+    gupta_cb_search_info_t report_info;
+    gupta_cb_search_best_move_t report_best_move;
+    void *user_data;
+
+    /* Represents the best move found by the last completed iteration of gupta_find_move(). */
+    move_t best_move;
+
+    /* Represents the best move found so far by the current iteration of gupta_find_move(). */
+    move_t root_best_move;
+
+    /* The expected reply to 'best_move', see gupta_get_ponder_move(). If there is none,
+     * 'ponder_move.from' is 0x88.
+     */
+    move_t ponder_move;
+
+    /* Set while the search is pondering, during which it ignores the search time, see
+     * gupta_set_search_pondering(). Cleared by a ponder hit from another thread, so it is accessed
+     * with ATOMIC_LOAD() and ATOMIC_STORE(), or with ATOMIC_STORE_RELEASE() and
+     * ATOMIC_LOAD_ACQUIRE() when it comes to the clock, see gupta_ponderhit().
+     */
+    int is_pondering;
+    /* Set by the thread that runs a pondering search until it notices the ponder hit, see
+     * check_ponderhit().
+     */
+    int awaits_ponderhit;
+
+    /* Set if the search plays the moves of the opening book, see gupta_set_search_book(). The
+     * book moves are chosen with a pseudo-random number generator, see next_random().
+     */
+    int use_book;
+    u64 random_state;
+
+    /* Set if the search looks positions up in the endgame tablebases, see
+     * gupta_set_search_tablebases().
+     */
+    int use_tablebases;
+
+    /* Indicates whether resignation is a sensible option (here meaning that, theoretically
+     * speaking, losing is unavoidable).
+     */
+    int is_resignation_sensible;
+
+    /* Use the gupta_get_search_depth() and gupta_set_search_depth() functions to retrieve and
+     * change these.
+     */
+    size_t search_depth,
+           search_time;
+
+    /* Set by gupta_set_search_clock(), in which case the search time is budgeted from the clock
+     * of the side to move, rather than being 'search_time'. The time is in milliseconds. As the
+     * clock may be set while pondering, 'use_clock' is accessed with ATOMIC_LOAD() and
+     * ATOMIC_STORE().
+     */
+    int use_clock;
+    size_t clock_time,
+           clock_increment,
+           clock_moves_to_go;
+
+    /* The time limits of the current search, in milliseconds since its start. The search aims to
+     * take about 'target_time', and never takes longer than 'hard_time_limit'. No iteration is
+     * started after 'soft_time_limit', which is adjusted between iterations. See allocate_time().
+     */
+    u64 target_time,
+        soft_time_limit,
+        hard_time_limit;
+
+    /* The number of legal moves in the position being searched, once the first iteration has
+     * completed.
+     */
+    size_t num_root_moves;
+
+    /* Set once the search has to stop. It may be set by any thread, see gupta_abort_search(),
+     * and the helpers of a search poll the one of the main search, see count_node(), so it is
+     * always accessed with ATOMIC_LOAD() and ATOMIC_STORE().
+     */
+    int abort_search;
+
+    /* The number of nodes searched by the last (or current) call to gupta_find_move(). While
+     * searching, the main search reads the node counts of its helpers, see count_all_nodes().
+     */
+    u64 search_nodes;
+
+    size_t interrupt_counter;
+
+    /* The time at which the search started, see timer_get_ms(). */
+    u64 search_start_time;
+
+    /* The generation of the transposition table entries that the search stores, see
+     * tt_begin_search().
+     */
+    u8 tt_generation;
+
+    packed_move_t killer_moves[GUPTA_SEARCH_DEPTH_MAX][NUM_KILLER_MOVES];
+
+    /* The history scores, indexable by the 0x88 board locations of a move's source and
+     * destination, count how often (weighted by the remaining search depth) a non-capturing move
+     * caused a beta cutoff anywhere in the game tree.
+     */
+    int history_scores[128][128];
+
+    /* For a helper of a Lazy SMP search, the search it helps and its index among the helpers
+     * (starting at 1). For any other search, NULL and 0.
+     */
+    gupta_search_t *main;
+    size_t helper_idx;
+
+    /* The helpers of this search, one for every search thread besides the calling thread of
+     * gupta_find_move(). See gupta_set_search_threads().
+     */
+    search_helper_t *helpers;
+    size_t num_helpers;
+};
 
-/* TODO XXX For debugging: used to keep track of the best move for every height in the tree,
- *                         so that after the search completes we can print the best move path. */
+/* A principal variation: the moves that the search expects to be played, best move first. */
 struct line
 {
     int count;
-    char moves[GUPTA_SEARCH_DEPTH_MAX][8];
-    int alphas[GUPTA_SEARCH_DEPTH_MAX];
+    move_t moves[GUPTA_SEARCH_DEPTH_MAX];
 };
 
-int is_search_time_exhausted(void);
-int search(size_t, int, int, struct line *);
-void snap_search_start_time(void);
+int search(gupta_search_t *s, int depth, size_t height, int alpha, int beta, int allow_null_move,
+           struct line *pline);
 
 #endif /* !defined(SEARCH_H) */
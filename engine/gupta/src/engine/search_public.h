@@ -14,21 +14,105 @@
 #ifndef SEARCH_PUBLIC_H
 #define SEARCH_PUBLIC_H
 
+#include "board_public.h"
+#include "move_public.h"
+#include "types.h"
+
 #include <stddef.h>
 
 #define GUPTA_SEARCH_DEPTH_MAX 80
 
-#define GUPTA_SEARCH_TIME_DEFAULT 15
+/* The search time is expressed in milliseconds. */
+#define GUPTA_SEARCH_TIME_DEFAULT 15000
+/* Search time that is never reached, so that only the search depth limits the search. */
+#define GUPTA_SEARCH_TIME_INFINITE ((size_t)-1)
+
+/* The maximum number of threads a single search may use, see gupta_set_search_threads(). */
+#define GUPTA_SEARCH_THREADS_MAX 64
+
+/* A search holds the state of the search algorithm: its limits, its statistics, the best move it
+ * found, and the move ordering heuristics it learned. A search only reads the position it is given
+ * by gupta_find_move(), and it needs no other state than the transposition table and the search
+ * parameters, which all searches share. Hence searches can run concurrently, as long as each has
+ * its own position.
+ */
+typedef struct gupta_search gupta_search_t;
+
+/* Information about an iteration of a search, once it is completed or once it has found a new best
+ * move, see gupta_set_search_info_cb().
+ */
+typedef struct
+{
+    /* The search depth of the iteration, in plies. */
+    size_t depth;
+    /* The score of the position, in centipawns, from the point of view of the side to move. */
+    int score;
+    /* If the score denotes a checkmate, the number of moves until checkmate, negative if the side
+     * to move is the one that gets checkmated. Otherwise 0.
+     */
+    int mate;
+    /* The number of nodes searched so far, by all threads, and the time spent so far, in
+     * milliseconds.
+     */
+    u64 nodes,
+        time;
+    /* The principal variation: the moves that the search expects to be played, best move first.
+     * Only valid during the callback.
+     */
+    const move_t *pv;
+    size_t pv_length;
+} gupta_search_info_t;
+
+/* The callbacks of a search are called by the thread that called gupta_find_move(). The interrupt
+ * callback is called regularly while searching, for example to process input, and may abort the
+ * search. The info callback is called after every iteration of the search, and whenever an
+ * iteration finds a new best move. The best move callback is called once the search is done. All
+ * of them are optional.
+ */
+typedef void (*gupta_cb_search_interrupt_t)(gupta_search_t *s);
+typedef void (*gupta_cb_search_info_t)(gupta_search_t *s, const gupta_search_info_t *info);
+typedef void (*gupta_cb_search_best_move_t)(gupta_search_t *s, const move_t *best_move);
 
-typedef void (*gupta_cb_search_interrupt_t)(void);
+/* A tunable search parameter, such as the depth reduction used by null move pruning. */
+typedef struct
+{
+    const char *name;
+    int is_boolean; /* Boolean parameters are either 0 (disabled) or 1 (enabled). */
+    int value,
+        min,
+        max;
+} gupta_search_param_t;
 
-void gupta_abort_search(void);
-void gupta_find_move(void);
-size_t gupta_get_search_depth(void);
-size_t gupta_get_search_time(void);
-int gupta_is_resignation_sensible(void);
-void gupta_set_search_depth(size_t new_search_depth);
-void gupta_set_search_interrupt(gupta_cb_search_interrupt_t cb);
-void gupta_set_search_time(size_t new_search_time);
+gupta_search_t *gupta_create_search(void);
+void gupta_destroy_search(gupta_search_t *s);
+void gupta_abort_search(gupta_search_t *s);
+void gupta_clear_search(gupta_search_t *s);
+void gupta_find_move(gupta_search_t *s, gupta_position_t *pos);
+const move_t *gupta_get_best_move(const gupta_search_t *s);
+const move_t *gupta_get_ponder_move(const gupta_search_t *s);
+size_t gupta_get_num_search_params(void);
+const gupta_search_param_t *gupta_get_search_param(size_t idx);
+int gupta_get_search_book(const gupta_search_t *s);
+size_t gupta_get_search_depth(const gupta_search_t *s);
+u64 gupta_get_search_nodes(const gupta_search_t *s);
+void *gupta_get_search_user_data(const gupta_search_t *s);
+size_t gupta_get_search_threads(const gupta_search_t *s);
+size_t gupta_get_search_time(const gupta_search_t *s);
+int gupta_get_search_tablebases(const gupta_search_t *s);
+int gupta_is_resignation_sensible(const gupta_search_t *s);
+void gupta_ponderhit(gupta_search_t *s);
+void gupta_set_search_book(gupta_search_t *s, int use_book);
+void gupta_set_search_depth(gupta_search_t *s, size_t new_search_depth);
+void gupta_set_search_best_move_cb(gupta_search_t *s, gupta_cb_search_best_move_t cb);
+void gupta_set_search_clock(gupta_search_t *s, size_t time_left, size_t increment,
+                            size_t moves_to_go);
+void gupta_set_search_info_cb(gupta_search_t *s, gupta_cb_search_info_t cb);
+void gupta_set_search_interrupt(gupta_search_t *s, gupta_cb_search_interrupt_t cb);
+int gupta_set_search_param(const char *name, int value);
+void gupta_set_search_pondering(gupta_search_t *s, int pondering);
+void gupta_set_search_tablebases(gupta_search_t *s, int use_tablebases);
+void gupta_set_search_threads(gupta_search_t *s, size_t new_search_threads);
+void gupta_set_search_time(gupta_search_t *s, size_t new_search_time);
+void gupta_set_search_user_data(gupta_search_t *s, void *user_data);
 
 #endif /* !defined(SEARCH_PUBLIC_H) */
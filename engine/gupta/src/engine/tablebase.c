@@ -0,0 +1,927 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Endgame tablebases. They hold the exact outcome of every position with at most
+ * GUPTA_TABLEBASE_PIECES_MAX pieces (kings included), and how many plies it takes to get there,
+ * so that the search looks such positions up rather than searching them. They are generated by
+ * retrograde analysis, see gupta_generate_tablebase(), for example by the 'gupta-tablebase'
+ * program (see 'src/tablebase/tablebase.c').
+ *
+ * Every material configuration, such as king and rook versus king ("KRK"), has a table of its own,
+ * in a file of its own ("KRK.tb"). The side with the most material is white in the tables, so the
+ * positions in which black has more are looked up with the colors reversed. A table holds a byte
+ * for every position, see 'tablebase.h', first for the positions with white to move, then for
+ * those with black to move.
+ * A position is indexed by the squares of its pieces, in the order white king, black king, the
+ * other white pieces and the other black pieces (both from the most to the least valuable). Each
+ * square is counted from a1 (0) to h8 (63), and for pawns from a2 (0) to h7 (47). Positions that
+ * are mirror images of each other share their entry: the position is mirrored such that the white
+ * king is on the queenside, and, if there are no pawns, on the lower half of the board as well.
+ * Of two identical pieces, the one on the lowest square comes first. Hence some entries don't
+ * correspond to any position, and neither do entries of illegal positions, but they are never
+ * looked up anyway, and this way the index is simple to compute.
+ *
+ * The tables assume that castling isn't possible, and neither is capturing En Passant, so the
+ * positions in which these are possible aren't looked up.
+ *
+ * The table files are mapped into memory, see 'file_map.c'.
+ */
+
+#include "tablebase.h"
+#include "bitboard.h"
+#include "board.h"
+#include "common.h"
+#include "enforce.h"
+#include "file_map.h"
+#include "move.h"
+#include "piece.h"
+#include "rules.h"
+#include "uassert.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TABLE_FILE_SUFFIX ".tb"
+
+/* The tables, in the order in which they have to be generated: every table may depend on the
+ * tables before it, as captures lead to positions with fewer pieces, and promotions to positions
+ * with fewer pawns.
+ */
+static const char *const table_names[] = {
+    "KQK", "KRK", "KBK", "KNK",
+    "KPK",
+    "KQQK", "KQRK", "KQBK", "KQNK", "KRRK", "KRBK", "KRNK", "KBBK", "KBNK", "KNNK",
+    "KQKQ", "KQKR", "KQKB", "KQKN", "KRKR", "KRKB", "KRKN", "KBKB", "KBKN", "KNKN",
+    "KQPK", "KRPK", "KBPK", "KNPK", "KQKP", "KRKP", "KBKP", "KNKP",
+    "KPPK", "KPKP"
+};
+
+typedef struct
+{
+    /* The pieces in the order in which their squares make up the index of a position. */
+    s8 pieces[GUPTA_TABLEBASE_PIECES_MAX];
+    size_t num_pieces;
+    int has_pawns;
+
+    /* The number of entries for either side to move. */
+    size_t size;
+
+    /* The mapped table file, or NULL if the table isn't open. */
+    const u8 *values;
+} table_t;
+
+static table_t tables[ARRAY_SIZE(table_names)];
+
+/* The tables indexed by the material of white and of black, see material_code(). */
+static table_t *tables_by_material[64][64];
+
+/* The piece types besides the king, from the most to the least valuable. */
+static const int piece_types[] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+
+/* The state of gupta_generate_tablebase(). For every entry of the table that is generated, it
+ * keeps the value (0 as long as it is unknown), the number of moves that aren't yet known to lose,
+ * and the value that moves to other tables lead to, see add_move_value().
+ */
+typedef struct
+{
+    table_t *table;
+    gupta_position_t *pos;
+    u8 *values,
+       *num_moves,
+       *other_values;
+    unsigned int max_value;
+} generator_t;
+
+/* Summarizes the material of a side besides its king, which is at most two pieces in the tables,
+ * as a number from 0 to 63. The more valuable the material, the higher the number.
+ */
+static int material_code(const u64 *pieces)
+{
+    int code = 0;
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(piece_types); i++)
+    {
+        u64 bb = pieces[piece_types[i]];
+
+        for (; bb; BB_CLEAR_LSB(bb))
+            code = code * 8 + piece_types[i];
+    }
+
+    /* A single piece is worth more than any two pieces of a lesser type. */
+    return code < 8 ? code * 8 : code;
+}
+
+static int piece_type_from_letter(char letter)
+{
+    switch (letter)
+    {
+    case 'Q': return QUEEN;
+    case 'R': return ROOK;
+    case 'B': return BISHOP;
+    case 'N': return KNIGHT;
+    case 'P': return PAWN;
+    default:
+        UASSERT(0 && "invalid table name");
+        return PAWN;
+    }
+}
+
+/* Derives the pieces of the tables from their names. */
+void init_tablebases()
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(tables); i++)
+    {
+        table_t *t = &tables[i];
+        const char *p = table_names[i];
+        u64 pieces[2][8];
+        int side = WHITE;
+        size_t j;
+
+        memset(pieces, 0, sizeof(pieces));
+        t->pieces[0] = MAKE_PIECE(WHITE, KING);
+        t->pieces[1] = MAKE_PIECE(BLACK, KING);
+        t->num_pieces = 2;
+        t->has_pawns = 0;
+
+        UASSERT(*p == 'K');
+        for (p++; *p; p++)
+        {
+            int type;
+
+            if (*p == 'K')
+            {
+                side = BLACK;
+                continue;
+            }
+
+            UASSERT(t->num_pieces < GUPTA_TABLEBASE_PIECES_MAX);
+            type = piece_type_from_letter(*p);
+            t->pieces[t->num_pieces++] = MAKE_PIECE(side, type);
+            t->has_pawns |= type == PAWN;
+
+            /* Only the number of pieces of each type matters to material_code(). */
+            pieces[side][type] = (pieces[side][type] << 1) | 1;
+        }
+
+        /* The white king is on the queenside, and without pawns on the lower half of the board. */
+        t->size = t->has_pawns ? 32 : 16;
+        for (j = 1; j < t->num_pieces; j++)
+            t->size *= PIECE_TYPE(t->pieces[j]) == PAWN ? 48 : 64;
+
+        tables_by_material[material_code(pieces[WHITE])][material_code(pieces[BLACK])] = t;
+    }
+}
+
+/* Returns the table of position 'pos', or NULL if there is none. Stores the squares of the pieces
+ * in the order of the table in 'squares', and the side to move in 'side', with the colors reversed
+ * if the table has them reversed.
+ */
+static table_t *find_table(const gupta_position_t *pos, u8 *squares, int *side)
+{
+    table_t *t;
+    int codes[2],
+        flip,
+        mirror,
+        table_side;
+    size_t i,
+           n = 2;
+
+    if (BB_POPCOUNT(OCCUPIED_SQUARES(pos)) > GUPTA_TABLEBASE_PIECES_MAX)
+        return NULL;
+
+    codes[WHITE] = material_code(pos->bitboards[WHITE]);
+    codes[BLACK] = material_code(pos->bitboards[BLACK]);
+
+    /* Reversing the colors also mirrors the board from top to bottom, so that the pawns still move
+     * up the board for white, and down for black.
+     */
+    flip = codes[WHITE] < codes[BLACK];
+    mirror = flip ? 56 : 0;
+
+    t = tables_by_material[codes[flip]][codes[!flip]];
+    if (!t)
+        return NULL;
+
+    squares[0] = (u8)(KING_SQUARE(pos, flip) ^ mirror);
+    squares[1] = (u8)(KING_SQUARE(pos, !flip) ^ mirror);
+    for (table_side = WHITE; table_side <= BLACK; table_side++)
+    {
+        for (i = 0; i < ARRAY_SIZE(piece_types); i++)
+        {
+            u64 bb = pos->bitboards[table_side ^ flip][piece_types[i]];
+
+            for (; bb; BB_CLEAR_LSB(bb))
+                squares[n++] = (u8)(BB_LSB(bb) ^ mirror);
+        }
+    }
+    UASSERT(n == t->num_pieces);
+
+    *side = pos->tside ^ flip;
+    return t;
+}
+
+/* Returns the index of the entry of the position with the pieces of table 't' on 'squares', and
+ * 'side' to move.
+ */
+static size_t position_index(const table_t *t, const u8 *squares, int side)
+{
+    u8 sq[GUPTA_TABLEBASE_PIECES_MAX] = {0};
+    int mirror = 0;
+    size_t idx,
+           i;
+
+    if ((squares[0] & 7) > 3)
+        mirror ^= 7;
+    if (!t->has_pawns && ((squares[0] >> 3) > 3))
+        mirror ^= 56;
+
+    for (i = 0; i < t->num_pieces; i++)
+        sq[i] = (u8)(squares[i] ^ mirror);
+
+    /* Only the other white pieces can be identical. */
+    if ((t->num_pieces == 4) && (t->pieces[2] == t->pieces[3]) && (sq[2] > sq[3]))
+    {
+        u8 tmp = sq[2];
+
+        sq[2] = sq[3];
+        sq[3] = tmp;
+    }
+
+    idx = (size_t)(sq[0] >> 3) * 4 + (sq[0] & 7);
+    for (i = 1; i < t->num_pieces; i++)
+    {
+        if (PIECE_TYPE(t->pieces[i]) == PAWN)
+            idx = idx * 48 + (size_t)(sq[i] - 8);
+        else
+            idx = idx * 64 + sq[i];
+    }
+
+    return (size_t)side * t->size + idx;
+}
+
+/* Returns whether either side may still castle. */
+static int has_castling_rights(const gupta_position_t *pos)
+{
+    int side;
+
+    for (side = WHITE; side <= BLACK; side++)
+    {
+        if (!(pos->castling & g_castling_masks[side][0]) ||
+            !(pos->castling & g_castling_masks[side][1]))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Returns whether a pawn of the side to move is next to the pawn that may be captured En Passant.
+ * The capture may still turn out to be illegal.
+ */
+static int may_capture_en_passant(const gupta_position_t *pos)
+{
+    int destination;
+
+    if (pos->en_passant == 0x88)
+        return 0;
+
+    destination = SQ64(pos->en_passant) + (pos->tside == WHITE ? 8 : -8);
+    return (g_pawn_attacks[pos->oside][destination] & pos->bitboards[pos->tside][PAWN]) != 0;
+}
+
+/* Looks position 'pos' up in the tablebases. Returns 0 if it isn't in any of the open tables, and
+ * otherwise stores its value (see 'tablebase.h') in 'value'.
+ */
+int tablebase_probe(const gupta_position_t *pos, unsigned int *value)
+{
+    u8 squares[GUPTA_TABLEBASE_PIECES_MAX];
+    const table_t *t;
+    int side;
+
+    if (BB_POPCOUNT(OCCUPIED_SQUARES(pos)) > GUPTA_TABLEBASE_PIECES_MAX)
+        return 0;
+
+    if (has_castling_rights(pos) || may_capture_en_passant(pos))
+        return 0;
+
+    /* Two bare kings have no table. */
+    if (BB_POPCOUNT(OCCUPIED_SQUARES(pos)) == 2)
+    {
+        *value = 0;
+        return 1;
+    }
+
+    t = find_table(pos, squares, &side);
+    if (!t || !t->values)
+        return 0;
+
+    *value = t->values[position_index(t, squares, side)];
+    return 1;
+}
+
+/* Ranks the value of a position for the side to move: the quicker a win, or the slower a loss, the
+ * higher the rank.
+ */
+static int value_rank(unsigned int value)
+{
+    if (TABLEBASE_IS_WIN(value))
+        return 512 - (int)value;
+    else if (TABLEBASE_IS_LOSS(value))
+        return (int)value - 512;
+    return 0;
+}
+
+/* Picks the move of position 'pos' that leads to the best outcome according to the tablebases,
+ * and stores it in 'm', and the value of the position in 'value'. Returns 0 if the tablebases
+ * don't hold the positions after all the moves.
+ */
+int tablebase_probe_root(gupta_position_t *pos, move_t *m, unsigned int *value)
+{
+    scored_move_t moves[MOVES_MAX];
+    size_t num_moves,
+           idx;
+    unsigned int best_value = 0;
+    int has_move = 0;
+
+    if (BB_POPCOUNT(OCCUPIED_SQUARES(pos)) > GUPTA_TABLEBASE_PIECES_MAX)
+        return 0;
+
+    num_moves = gen_moves(pos, GEN_ALL, moves);
+
+    for (idx = 0; idx < num_moves; idx++)
+    {
+        move_t child_move;
+        unsigned int child_value;
+        int found;
+
+        UNPACK_MOVE(child_move, moves[idx].move);
+        (void)make_move(pos, &child_move, MOVE_NOSTRICT_VALIDATION);
+        found = tablebase_probe(pos, &child_value);
+        gupta_undo_move(pos);
+
+        if (!found)
+            return 0;
+
+        /* The value of the position after the move is that of the opponent. */
+        if (!has_move || (value_rank(child_value) < value_rank(best_value)))
+        {
+            *m = child_move;
+            best_value = child_value;
+            has_move = 1;
+        }
+    }
+
+    if (!has_move)
+        return 0;
+
+    *value = best_value ? best_value + 1 : 0;
+    return 1;
+}
+
+static char *make_table_path(const char *path, size_t idx)
+{
+    size_t size = strlen(path) + 1 + strlen(table_names[idx]) + strlen(TABLE_FILE_SUFFIX) + 1;
+    char *p = malloc(size);
+
+    if (!p)
+        enforce(0 && "out of memory");
+
+    sprintf(p, "%s/%s%s", path, table_names[idx], TABLE_FILE_SUFFIX);
+    return p;
+}
+
+static void close_table(table_t *t)
+{
+    if (!t->values)
+        return;
+
+    unmap_file(t->values, t->size * 2);
+    t->values = NULL;
+}
+
+void gupta_close_tablebases()
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(tables); i++)
+        close_table(&tables[i]);
+}
+
+/* Opens the tables in the directory 'path', instead of any tables that were open. Tables that are
+ * missing are skipped. Returns the number of tables that were opened.
+ */
+size_t gupta_open_tablebases(const char *path)
+{
+    size_t num_opened = 0,
+           i;
+
+    gupta_close_tablebases();
+
+    for (i = 0; i < ARRAY_SIZE(tables); i++)
+    {
+        table_t *t = &tables[i];
+        char *table_path = make_table_path(path, i);
+        const void *view;
+        size_t size;
+
+        view = map_file(table_path, &size);
+        free(table_path);
+
+        if (!view)
+            continue;
+
+        if (size != t->size * 2)
+        {
+            unmap_file(view, size);
+            continue;
+        }
+
+        t->values = view;
+        num_opened++;
+    }
+
+    return num_opened;
+}
+
+size_t gupta_get_num_tablebases()
+{
+    return ARRAY_SIZE(tables);
+}
+
+/* Returns the name of a table, such as "KRK" for king and rook versus king. The tables are indexed
+ * from 0 up to gupta_get_num_tablebases(), in the order in which they have to be generated.
+ */
+const char *gupta_get_tablebase_name(size_t idx)
+{
+    UASSERT(idx < ARRAY_SIZE(tables));
+    return table_names[idx];
+}
+
+/* The inverse of position_index(), for an index that doesn't include the side to move. */
+static void decode_index(const table_t *t, size_t idx, u8 *squares)
+{
+    size_t i;
+
+    for (i = t->num_pieces - 1; i > 0; i--)
+    {
+        if (PIECE_TYPE(t->pieces[i]) == PAWN)
+        {
+            squares[i] = (u8)(idx % 48 + 8);
+            idx /= 48;
+        }
+        else
+        {
+            squares[i] = (u8)(idx % 64);
+            idx /= 64;
+        }
+    }
+
+    squares[0] = (u8)((idx / 4) * 8 + idx % 4);
+}
+
+/* Returns whether the pieces of table 't' on 'squares' are placed as the index expects them to be,
+ * that is, on different squares, and with identical pieces in order.
+ */
+static int is_valid_placement(const table_t *t, const u8 *squares)
+{
+    u64 occupied = 0;
+    size_t i;
+
+    for (i = 0; i < t->num_pieces; i++)
+    {
+        if (occupied & BB_SQUARE(squares[i]))
+            return 0;
+        occupied |= BB_SQUARE(squares[i]);
+    }
+
+    return !((t->num_pieces == 4) && (t->pieces[2] == t->pieces[3]) && (squares[2] > squares[3]));
+}
+
+/* Returns whether 'side' attacks square 'sq', with the pieces of table 't' on 'squares'. */
+static int is_attacked(const table_t *t, const u8 *squares, int sq, int side)
+{
+    u64 occupied = 0,
+        target = BB_SQUARE(sq);
+    size_t i;
+
+    for (i = 0; i < t->num_pieces; i++)
+        occupied |= BB_SQUARE(squares[i]);
+
+    for (i = 0; i < t->num_pieces; i++)
+    {
+        int type = PIECE_TYPE(t->pieces[i]);
+
+        if (PIECE_SIDE(t->pieces[i]) != side)
+            continue;
+
+        if (type == PAWN)
+        {
+            if (g_pawn_attacks[side][squares[i]] & target)
+                return 1;
+        }
+        else if (piece_attacks(type, squares[i], occupied) & target)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Sets up the engine's position of the generator for the pieces of the table on 'squares'. */
+static void set_up_position(generator_t *g, const u8 *squares, int side)
+{
+    u8 locations[GUPTA_TABLEBASE_PIECES_MAX];
+    size_t i;
+
+    for (i = 0; i < g->table->num_pieces; i++)
+        locations[i] = (u8)SQ88(squares[i]);
+
+    set_board_from_pieces(g->pos, g->table->pieces, locations, g->table->num_pieces, side);
+}
+
+static void set_value(generator_t *g, size_t idx, unsigned int value)
+{
+    /* The values of at most four pieces stay far below this. */
+    UASSERT(value <= 0xFF);
+
+    g->values[idx] = (u8)value;
+    if (value > g->max_value)
+        g->max_value = value;
+}
+
+/* In position 'pos', in which the side to move may capture En Passant, which the tables don't
+ * take into account, stores the best value the side to move gets by doing so in 'value', or stores
+ * -1 if no such capture is legal. Returns 0 if a table is missing.
+ */
+static int probe_en_passant_captures(gupta_position_t *pos, int *value)
+{
+    scored_move_t moves[MOVES_MAX];
+    size_t num_moves,
+           idx;
+    u8 destination = (u8)(pos->en_passant + (pos->tside == WHITE ? 0x10 : -0x10));
+
+    *value = -1;
+    num_moves = gen_moves(pos, GEN_NOISY, moves);
+
+    for (idx = 0; idx < num_moves; idx++)
+    {
+        move_t m;
+        unsigned int child_value,
+                     capture_value;
+        int found;
+
+        UNPACK_MOVE(m, moves[idx].move);
+        if ((m.to != destination) || (PIECE_TYPE(pos->board[m.from]) != PAWN))
+            continue;
+
+        (void)make_move(pos, &m, MOVE_NOSTRICT_VALIDATION);
+        found = tablebase_probe(pos, &child_value);
+        gupta_undo_move(pos);
+
+        if (!found)
+            return 0;
+
+        capture_value = child_value ? child_value + 1 : 0;
+        if ((*value == -1) || (value_rank(capture_value) > value_rank((unsigned int)*value)))
+            *value = (int)capture_value;
+    }
+
+    return 1;
+}
+
+/* Takes the value of the position after a move of the entry 'idx' into account, if it is one of
+ * another table (or one in which the opponent may capture En Passant). If the move wins, its
+ * value is kept if it is the quickest win so far. If it loses, its value is kept if it is the
+ * slowest loss so far, unless there is a winning move. Other than losing moves, the moves count
+ * towards the moves that aren't yet known to lose.
+ */
+static void add_move_value(generator_t *g, size_t idx, unsigned int child_value)
+{
+    unsigned int value = child_value ? child_value + 1 : 0,
+                 other_value = g->other_values[idx];
+
+    if (TABLEBASE_IS_WIN(value))
+    {
+        if (!TABLEBASE_IS_WIN(other_value) || (value < other_value))
+            g->other_values[idx] = (u8)value;
+    }
+    else if (TABLEBASE_IS_LOSS(value))
+    {
+        if (!TABLEBASE_IS_WIN(other_value) && (value > other_value))
+            g->other_values[idx] = (u8)value;
+        return;
+    }
+
+    g->num_moves[idx]++;
+}
+
+/* Generates the moves of the entry 'idx', and counts the ones that stay within the table. Returns
+ * 0 if a table is missing, and 1 otherwise, also if the entry isn't a legal position.
+ */
+static int init_entry(generator_t *g, size_t idx, size_t *num_legal)
+{
+    table_t *t = g->table;
+    gupta_position_t *pos = g->pos;
+    scored_move_t moves[MOVES_MAX];
+    size_t num_moves,
+           i;
+    u8 squares[GUPTA_TABLEBASE_PIECES_MAX];
+    int side = (int)(idx / t->size);
+
+    decode_index(t, idx % t->size, squares);
+    if (!is_valid_placement(t, squares))
+        return 1;
+
+    set_up_position(g, squares, side);
+
+    /* The side that just moved can't be in check. */
+    if (is_king_in_check(pos, pos->oside))
+        return 1;
+
+    (*num_legal)++;
+
+    num_moves = gen_moves(pos, GEN_ALL, moves);
+
+    for (i = 0; i < num_moves; i++)
+    {
+        move_t m;
+        u8 child_squares[GUPTA_TABLEBASE_PIECES_MAX];
+        unsigned int child_value;
+        int child_side,
+            capture_value,
+            found = 1;
+
+        UNPACK_MOVE(m, moves[i].move);
+        (void)make_move(pos, &m, MOVE_NOSTRICT_VALIDATION);
+
+        if (find_table(pos, child_squares, &child_side) != t)
+        {
+            found = tablebase_probe(pos, &child_value);
+            if (found)
+                add_move_value(g, idx, child_value);
+        }
+        else if (may_capture_en_passant(pos))
+        {
+            /* If capturing En Passant wins, the entry of the position after the move doesn't
+             * matter, see propagate().
+             */
+            found = probe_en_passant_captures(pos, &capture_value);
+            if (found && (capture_value != -1) && TABLEBASE_IS_WIN((unsigned int)capture_value))
+                add_move_value(g, idx, (unsigned int)capture_value);
+            else
+                g->num_moves[idx]++;
+        }
+        else
+            g->num_moves[idx]++;
+
+        gupta_undo_move(pos);
+
+        if (!found)
+            return 0;
+    }
+
+    if (num_moves == 0)
+    {
+        /* Checkmate, or a draw by stalemate. */
+        if (is_king_in_check(pos, pos->tside))
+            set_value(g, idx, 1);
+    }
+    else if (g->num_moves[idx] == 0)
+    {
+        /* All the moves lead to other tables, and lose. */
+        UASSERT(TABLEBASE_IS_LOSS(g->other_values[idx]));
+        set_value(g, idx, g->other_values[idx]);
+    }
+    else if (g->other_values[idx] > g->max_value)
+        g->max_value = g->other_values[idx];
+
+    return 1;
+}
+
+/* Takes back the move of the piece 'slot' to square 'from', which led from another entry to the
+ * one with the pieces on 'squares', the value of which has just become 'value'. If the entry
+ * loses, the move wins, unless 'may_win' is 0. If the entry wins, the move loses, and if it was
+ * the last move that wasn't yet known to lose, the position before it loses.
+ */
+static void unmove(generator_t *g, const u8 *squares, size_t slot, int from, unsigned int value,
+                   int may_win)
+{
+    table_t *t = g->table;
+    u8 previous[GUPTA_TABLEBASE_PIECES_MAX];
+    int side = PIECE_SIDE(t->pieces[slot]);
+    unsigned int other_value;
+    size_t idx;
+
+    memcpy(previous, squares, t->num_pieces);
+    previous[slot] = (u8)from;
+
+    /* The side to move can't have the opponent's king in check. */
+    if (is_attacked(t, previous, previous[side == WHITE ? 1 : 0], side))
+        return;
+
+    idx = position_index(t, previous, side);
+    if (g->values[idx])
+        return;
+
+    if (TABLEBASE_IS_LOSS(value))
+    {
+        if (may_win)
+            set_value(g, idx, value + 1);
+        return;
+    }
+
+    UASSERT(g->num_moves[idx] > 0);
+    if (--g->num_moves[idx] > 0)
+        return;
+
+    other_value = g->other_values[idx];
+    UASSERT(!TABLEBASE_IS_WIN(other_value));
+    set_value(g, idx, other_value > value + 1 ? other_value : value + 1);
+}
+
+/* Takes back all the moves that lead to the entry 'idx', the value of which has just become known.
+ * Returns 0 if a table is missing.
+ */
+static int propagate(generator_t *g, size_t idx)
+{
+    table_t *t = g->table;
+    u8 squares[GUPTA_TABLEBASE_PIECES_MAX];
+    int side = (int)(idx / t->size),
+        moved_side = side ^ 1;
+    unsigned int value = g->values[idx];
+    u64 occupied = 0;
+    size_t i;
+
+    decode_index(t, idx % t->size, squares);
+    for (i = 0; i < t->num_pieces; i++)
+        occupied |= BB_SQUARE(squares[i]);
+
+    for (i = 0; i < t->num_pieces; i++)
+    {
+        int type = PIECE_TYPE(t->pieces[i]),
+            step,
+            from,
+            capture_value,
+            may_win = 1;
+        u64 froms;
+
+        if (PIECE_SIDE(t->pieces[i]) != moved_side)
+            continue;
+
+        if (type != PAWN)
+        {
+            froms = piece_attacks(type, squares[i], occupied) & ~occupied;
+            for (; froms; BB_CLEAR_LSB(froms))
+                unmove(g, squares, i, BB_LSB(froms), value, 1);
+            continue;
+        }
+
+        /* Pawns never stood on their first rank, and those on their second rank never moved. */
+        step = moved_side == WHITE ? -8 : 8;
+        from = squares[i] + step;
+        if ((from < 8) || (from >= 56) || (occupied & BB_SQUARE(from)))
+            continue;
+        unmove(g, squares, i, from, value, 1);
+
+        if (((squares[i] >> 3) != (moved_side == WHITE ? 3 : 4)) ||
+            (occupied & BB_SQUARE(from + step)))
+        {
+            continue;
+        }
+
+        /* The tables don't take En Passant into account, so if the opponent may capture En
+         * Passant after a double push, the entry doesn't tell the value of the position after it.
+         * If capturing wins, the push was counted as a move that loses, see init_entry(), and if
+         * capturing draws, the push doesn't win, whatever the entry says.
+         */
+        set_up_position(g, squares, side);
+        g->pos->en_passant = (u8)SQ88(squares[i]);
+        if (may_capture_en_passant(g->pos))
+        {
+            if (!probe_en_passant_captures(g->pos, &capture_value))
+                return 0;
+
+            if ((capture_value != -1) && TABLEBASE_IS_WIN((unsigned int)capture_value))
+                continue;
+            may_win = (capture_value == -1) || TABLEBASE_IS_LOSS((unsigned int)capture_value);
+        }
+        unmove(g, squares, i, from + step, value, may_win);
+    }
+
+    return 1;
+}
+
+/* Generates table 'idx' (see gupta_get_tablebase_name()) by retrograde analysis, and writes it to
+ * the directory 'path', which has to hold the tables that come before it. Afterwards, the tables
+ * in 'path' are open, see gupta_open_tablebases(). Returns 0 if a table is missing or if the table
+ * couldn't be written, and otherwise stores the outcomes of its positions in 'stats'.
+ *
+ * First, the moves of every position are generated. Checkmates get their value right away, as do
+ * the positions of which all the moves lead to other tables and lose. The moves that stay within
+ * the table are counted. Then, starting from the checkmates, the values are propagated backward
+ * one ply at a time, by taking back moves: a position from which a move leads to a loss wins, and
+ * a position of which all the moves lead to wins loses. The positions that are left can't be
+ * forced either way, and are draws.
+ */
+int gupta_generate_tablebase(const char *path, size_t idx, gupta_tablebase_stats_t *stats)
+{
+    generator_t g;
+    table_t *t;
+    size_t num_entries,
+           num_legal = 0,
+           i;
+    unsigned int value;
+    char *table_path = NULL;
+    FILE *f = NULL;
+    int result = 0;
+
+    UASSERT(idx < ARRAY_SIZE(tables));
+    t = &tables[idx];
+    num_entries = t->size * 2;
+
+    /* The tables that come before are looked up while generating, but the table itself is about
+     * to be overwritten.
+     */
+    (void)gupta_open_tablebases(path);
+    close_table(t);
+
+    memset(&g, 0, sizeof(g));
+    g.table = t;
+    g.pos = gupta_create_position();
+    g.values = calloc(num_entries, 1);
+    g.num_moves = calloc(num_entries, 1);
+    g.other_values = calloc(num_entries, 1);
+    if (!g.values || !g.num_moves || !g.other_values)
+        enforce(0 && "out of memory");
+
+    for (i = 0; i < num_entries; i++)
+    {
+        if (!init_entry(&g, i, &num_legal))
+            goto done;
+    }
+
+    for (value = 1; value <= g.max_value; value++)
+    {
+        for (i = 0; i < num_entries; i++)
+        {
+            /* A win by a move to another table is only certain once the table has no quicker
+             * win.
+             */
+            if (!g.values[i] && (g.other_values[i] == value) && TABLEBASE_IS_WIN(value))
+                set_value(&g, i, value);
+
+            if ((g.values[i] == value) && !propagate(&g, i))
+                goto done;
+        }
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    for (i = 0; i < num_entries; i++)
+    {
+        if (TABLEBASE_IS_WIN(g.values[i]))
+            stats->num_wins++;
+        else if (TABLEBASE_IS_LOSS(g.values[i]))
+            stats->num_losses++;
+
+        if (g.values[i] && (g.values[i] - 1u > stats->longest_mate))
+            stats->longest_mate = g.values[i] - 1u;
+    }
+    stats->num_draws = num_legal - stats->num_wins - stats->num_losses;
+
+    table_path = make_table_path(path, idx);
+    f = fopen(table_path, "wb");
+    if (!f || (fwrite(g.values, 1, num_entries, f) != num_entries))
+        goto done;
+
+    result = 1;
+
+done:
+    if (f && (fclose(f) != 0))
+        result = 0;
+    if (result)
+        (void)gupta_open_tablebases(path);
+
+    free(table_path);
+    free(g.values);
+    free(g.num_moves);
+    free(g.other_values);
+    gupta_destroy_position(g.pos);
+
+    return result;
+}
@@ -0,0 +1,33 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "board_public.h"
+#include "move_public.h"
+#include "tablebase_public.h"
+
+/* The value of a position in the endgame tablebases is 0 for a draw, and otherwise 1 more than the
+ * number of plies until checkmate. The number of plies is odd if the side to move delivers the
+ * checkmate, and even if it is the one that gets checkmated.
+ */
+#define TABLEBASE_IS_WIN(value)  (((value) != 0) && ((value) % 2 == 0))
+#define TABLEBASE_IS_LOSS(value) ((value) % 2 != 0)
+
+void init_tablebases(void);
+int tablebase_probe(const gupta_position_t *pos, unsigned int *value);
+int tablebase_probe_root(gupta_position_t *pos, move_t *m, unsigned int *value);
+
+#endif /* !defined(TABLEBASE_H) */
@@ -0,0 +1,45 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef TABLEBASE_PUBLIC_H
+#define TABLEBASE_PUBLIC_H
+
+#include <stddef.h>
+
+/* The directory of endgame tablebases that the CECP interface opens at startup, if it exists. */
+#define GUPTA_TABLEBASE_PATH_DEFAULT "gupta-tablebases"
+
+/* The most pieces (kings included) of the positions in the endgame tablebases. */
+#define GUPTA_TABLEBASE_PIECES_MAX 4
+
+/* The outcomes of the legal positions of a table, as counted by gupta_generate_tablebase(). The
+ * wins and losses are those of the side to move.
+ */
+typedef struct
+{
+    size_t num_wins,
+           num_draws,
+           num_losses;
+    /* The longest distance to checkmate of any position, in plies. */
+    size_t longest_mate;
+} gupta_tablebase_stats_t;
+
+void gupta_close_tablebases(void);
+size_t gupta_open_tablebases(const char *path);
+
+int gupta_generate_tablebase(const char *path, size_t idx, gupta_tablebase_stats_t *stats);
+size_t gupta_get_num_tablebases(void);
+const char *gupta_get_tablebase_name(size_t idx);
+
+#endif /* !defined(TABLEBASE_PUBLIC_H) */
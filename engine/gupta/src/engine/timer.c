@@ -0,0 +1,54 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#include "timer.h"
+#include "uassert.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else /* !defined(_WIN32) */
+#include <time.h>
+#endif /* !defined(_WIN32) */
+
+u64 timer_get_ms()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    BOOL r;
+
+    if (frequency.QuadPart == 0)
+    {
+        r = QueryPerformanceFrequency(&frequency);
+        UASSERT(r && (frequency.QuadPart != 0));
+    }
+
+    r = QueryPerformanceCounter(&counter);
+    UASSERT(r);
+    (void)r;
+
+    /* Split the division to avoid overflowing the intermediate product. */
+    return (u64)(counter.QuadPart / frequency.QuadPart) * 1000 +
+           (u64)((counter.QuadPart % frequency.QuadPart) * 1000 / frequency.QuadPart);
+#else /* !defined(_WIN32) */
+    struct timespec t;
+    int r;
+
+    r = clock_gettime(CLOCK_MONOTONIC, &t);
+    UASSERT(r == 0);
+    (void)r;
+
+    return (u64)t.tv_sec * 1000 + (u64)(t.tv_nsec / 1000000);
+#endif /* !defined(_WIN32) */
+}
@@ -0,0 +1,26 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "types.h"
+
+/* Returns the number of milliseconds elapsed since some unspecified starting point. The clock is
+ * monotonic, so unlike the wall-clock time it never jumps backward (or forward) when the system
+ * time is changed. Only differences between two return values are meaningful.
+ */
+u64 timer_get_ms(void);
+
+#endif /* !defined(TIMER_H) */
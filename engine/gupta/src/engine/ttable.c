@@ -0,0 +1,317 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+/*
+ * Transposition table. Remembers the results of searched positions, so that a position that is
+ * reached again via a different move order (a transposition) doesn't have to be searched again.
+ * The table has a fixed size, each position maps to exactly one entry, which is replaced when a
+ * more valuable result for another position comes along.
+ *
+ * The table is shared by all search threads, without locking (see Hyatt and Mann, "A lockless
+ * transposition table implementation for parallel search"). An entry consists of two 64-bit words:
+ * the search result packed into one word, and the hash key XOR-ed with that word. Two threads
+ * writing the same entry at once may leave it with the words of different results, but then the
+ * key no longer matches when the entry is probed, so such a torn entry is simply not found.
+ *
+ * The table is also shared by all searches, which may run at the same time. Every search is
+ * enclosed by tt_begin_search() and tt_end_search(), and the table can only be resized or cleared
+ * while no search is running, which is enforced under 'tt_mutex'. The search parameters (see
+ * 'search.c') are shared the same way, see tt_lock_if_idle().
+ */
+
+#include "ttable.h"
+#include "compiler_specific.h"
+#include "enforce.h"
+#include "thread.h"
+#include "uassert.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The layout of the packed search results, see pack_entry(). The score is stored as a 24-bit
+ * two's complement number.
+ */
+#define DATA_FROM_SHIFT       0
+#define DATA_TO_SHIFT         8
+#define DATA_PROMOTE_SHIFT    16
+#define DATA_BOUND_SHIFT      20
+#define DATA_DEPTH_SHIFT      24
+#define DATA_GENERATION_SHIFT 32
+#define DATA_SCORE_SHIFT      40
+#define DATA_SCORE_SIGN       0x800000
+
+typedef struct
+{
+    u64 key_xor_data,
+        data;
+} tt_slot_t;
+
+static tt_slot_t *table = NULL;
+/* Number of entries in 'table', always a power of two (or zero if there's no table yet). */
+static size_t num_entries = 0;
+/* Private variable, use gupta_get_hash_size() to retrieve it. */
+static size_t hash_size = 0;
+
+/* Incremented whenever a search starts while no other search is running, to be able to tell which
+ * entries were stored by earlier searches. Those entries are replaced before the entries of the
+ * current searches. Searches that run at the same time share a generation, so that they don't age
+ * each other's entries. Each search keeps a copy, see tt_begin_search().
+ */
+static u8 generation = 0;
+
+/* Guards all of the above, and 'num_searches'. */
+static mutex_t tt_mutex;
+/* The number of searches between tt_begin_search() and tt_end_search(). */
+static size_t num_searches = 0;
+
+static tt_slot_t *slot_for_key(u64 key)
+{
+    UASSERT(table && "tt_begin_search() must be called before the table is used");
+
+    return &table[key & (num_entries - 1)];
+}
+
+static u64 pack_entry(const tt_entry_t *entry)
+{
+    return ((u64)entry->move.from << DATA_FROM_SHIFT) |
+           ((u64)entry->move.to << DATA_TO_SHIFT) |
+           ((u64)entry->move.promote << DATA_PROMOTE_SHIFT) |
+           ((u64)entry->bound << DATA_BOUND_SHIFT) |
+           ((u64)entry->depth << DATA_DEPTH_SHIFT) |
+           ((u64)entry->generation << DATA_GENERATION_SHIFT) |
+           ((u64)((u32)entry->score & 0xFFFFFF) << DATA_SCORE_SHIFT);
+}
+
+static void unpack_entry(tt_entry_t *entry, u64 data)
+{
+    entry->move.from = (u8)(data >> DATA_FROM_SHIFT);
+    entry->move.to = (u8)(data >> DATA_TO_SHIFT);
+    entry->move.promote = (u8)((data >> DATA_PROMOTE_SHIFT) & 0x0F);
+    entry->bound = (u8)((data >> DATA_BOUND_SHIFT) & 0x0F);
+    entry->depth = (u8)(data >> DATA_DEPTH_SHIFT);
+    entry->generation = (u8)(data >> DATA_GENERATION_SHIFT);
+    entry->score = (s32)((data >> DATA_SCORE_SHIFT) ^ DATA_SCORE_SIGN) - DATA_SCORE_SIGN;
+}
+
+/* Reads the entry for the position with the given key. Returns 0 if the slot holds an entry for
+ * another position (or a torn entry, see the top of this file).
+ */
+static int read_slot(const tt_slot_t *slot, u64 key, tt_entry_t *entry)
+{
+    u64 key_xor_data = ATOMIC_LOAD(&slot->key_xor_data),
+        data = ATOMIC_LOAD(&slot->data);
+
+    if ((key_xor_data ^ data) != key)
+        return 0;
+
+    unpack_entry(entry, data);
+    return 1;
+}
+
+/* Must be called with 'tt_mutex' locked, and while no search is running. */
+static void clear_table(void)
+{
+    if (table)
+        memset(table, 0, num_entries * sizeof(*table));
+    generation = 0;
+}
+
+/* Must be called with 'tt_mutex' locked, and while no search is running. See
+ * gupta_set_hash_size().
+ */
+static int resize_table(size_t megabytes)
+{
+    size_t n = 1;
+    tt_slot_t *p;
+
+    if (megabytes == 0)
+        megabytes = GUPTA_HASH_SIZE_DEFAULT;
+    else if (megabytes > GUPTA_HASH_SIZE_MAX)
+        return 0;
+
+    /* Round the number of entries down to a power of two, so that an entry can be selected by
+     * masking the key.
+     */
+    while ((n * 2 * sizeof(*table)) <= (megabytes * 1024 * 1024))
+        n *= 2;
+
+    p = malloc(n * sizeof(*table));
+    if (!p)
+        return 0;
+
+    free(table);
+    table = p;
+    num_entries = n;
+    hash_size = megabytes;
+
+    clear_table();
+    return 1;
+}
+
+/* Clears the transposition table. Returns 0 if a search is running, in which case the table is
+ * left as it is.
+ */
+int gupta_clear_hash()
+{
+    if (!tt_lock_if_idle())
+        return 0;
+
+    clear_table();
+    tt_unlock();
+    return 1;
+}
+
+size_t gupta_get_hash_size()
+{
+    return hash_size;
+}
+
+/* Resizes the transposition table to (at most) the given number of megabytes, and clears it. A
+ * size of 0 selects the default size. Returns 0 if a search is running, if the size exceeds
+ * GUPTA_HASH_SIZE_MAX, or when the memory couldn't be allocated, in which case the old table is
+ * kept.
+ */
+int gupta_set_hash_size(size_t megabytes)
+{
+    int r;
+
+    if (!tt_lock_if_idle())
+        return 0;
+
+    r = resize_table(megabytes);
+    tt_unlock();
+    return r;
+}
+
+void init_ttable()
+{
+    mutex_init(&tt_mutex);
+}
+
+void tt_free()
+{
+    UASSERT((num_searches == 0) && "the table is freed while a search is running");
+
+    free(table);
+    table = NULL;
+    num_entries = 0;
+    hash_size = 0;
+
+    mutex_destroy(&tt_mutex);
+}
+
+/* Must be called before every search, and tt_end_search() after it. The table is created here,
+ * rather than when it is first used, as then threads searching at the same time could each create
+ * one. Returns the generation that the search passes to tt_store().
+ */
+u8 tt_begin_search()
+{
+    u8 search_generation;
+
+    mutex_lock(&tt_mutex);
+
+    if (!table && !resize_table(GUPTA_HASH_SIZE_DEFAULT))
+        enforce(0 && "out of memory");
+
+    if (num_searches == 0)
+        generation++;
+    num_searches++;
+    search_generation = generation;
+
+    mutex_unlock(&tt_mutex);
+    return search_generation;
+}
+
+void tt_end_search()
+{
+    mutex_lock(&tt_mutex);
+
+    UASSERT(num_searches > 0);
+    num_searches--;
+
+    mutex_unlock(&tt_mutex);
+}
+
+/* Locks the state that all searches share, if no search is running, so that it can be changed
+ * safely. The lock must then be released with tt_unlock(). Returns 0, without locking, if a search
+ * is running.
+ */
+int tt_lock_if_idle()
+{
+    mutex_lock(&tt_mutex);
+
+    if (num_searches > 0)
+    {
+        mutex_unlock(&tt_mutex);
+        return 0;
+    }
+
+    return 1;
+}
+
+void tt_unlock()
+{
+    mutex_unlock(&tt_mutex);
+}
+
+/* Copies the entry for the position with the given key into 'entry'. Returns 0 if the table has no
+ * entry for it.
+ */
+int tt_probe(u64 key, tt_entry_t *entry)
+{
+    return read_slot(slot_for_key(key), key, entry) && (entry->depth != 0);
+}
+
+/* Stores a search result. 'depth' is the remaining search depth the result was obtained with, and
+ * must be at least 1. 'search_generation' is the generation returned by tt_begin_search().
+ */
+void tt_store(u64 key, int depth, int bound, int score, const move_t *move, u8 search_generation)
+{
+    tt_slot_t *slot = slot_for_key(key);
+    tt_entry_t entry;
+    u64 data;
+    int is_same_position;
+
+    UASSERT((depth > 0) && (depth <= 0xFF));
+    UASSERT((score > -DATA_SCORE_SIGN) && (score < DATA_SCORE_SIGN));
+
+    is_same_position = read_slot(slot, key, &entry);
+    if (!is_same_position)
+    {
+        /* Another position's entry, or a torn one, whose fields are decoded only to decide whether
+         * to replace it.
+         */
+        unpack_entry(&entry, ATOMIC_LOAD(&slot->data));
+    }
+
+    /* Keep the results of deeper searches of the current search, as they saved the most work.
+     * Results from earlier searches are always replaced.
+     */
+    if ((entry.generation == search_generation) && (depth < entry.depth))
+        return;
+
+    /* Don't forget the best move of an earlier search of this position if this search didn't find
+     * one.
+     */
+    if ((move->from != 0x88) || !is_same_position)
+        entry.move = *move;
+
+    entry.score = score;
+    entry.depth = depth;
+    entry.bound = bound;
+    entry.generation = search_generation;
+
+    data = pack_entry(&entry);
+    ATOMIC_STORE(&slot->key_xor_data, key ^ data);
+    ATOMIC_STORE(&slot->data, data);
+}
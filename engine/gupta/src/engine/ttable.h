@@ -0,0 +1,47 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include "ttable_public.h"
+#include "move_public.h"
+#include "types.h"
+
+/* Bound types of the scores stored in the transposition table. */
+#define TT_BOUND_EXACT 0 /* The score is exact. */
+#define TT_BOUND_LOWER 1 /* The score is at least as high as the stored score (fail-high). */
+#define TT_BOUND_UPPER 2 /* The score is at most as high as the stored score (fail-low). */
+
+/* A search result, as stored in the transposition table. */
+typedef struct
+{
+    s32    score;
+    /* The best move found in the position. If no move was found, 'move.from' is 0x88. */
+    move_t move;
+    u8     depth,
+           bound,
+           generation;
+} tt_entry_t;
+
+void init_ttable(void);
+u8 tt_begin_search(void);
+void tt_end_search(void);
+void tt_free(void);
+int tt_lock_if_idle(void);
+int tt_probe(u64 key, tt_entry_t *entry);
+void tt_store(u64 key, int depth, int bound, int score, const move_t *move,
+              u8 search_generation);
+void tt_unlock(void);
+
+#endif /* !defined(TTABLE_H) */
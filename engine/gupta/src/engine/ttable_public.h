@@ -0,0 +1,31 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef TTABLE_PUBLIC_H
+#define TTABLE_PUBLIC_H
+
+#include <stddef.h>
+
+/* Size of the transposition table, in megabytes. */
+#define GUPTA_HASH_SIZE_DEFAULT 16
+/* The largest size, such that twice the number of bytes still fits in a size_t. */
+#define GUPTA_HASH_SIZE_MAX (((size_t)-1 / 2) / (1024 * 1024))
+
+/* The transposition table is shared by all searches, so it can only be resized or cleared while
+ * no search is running. Otherwise these functions fail.
+ */
+int gupta_clear_hash(void);
+size_t gupta_get_hash_size(void);
+int gupta_set_hash_size(size_t megabytes);
+
+#endif /* !defined(TTABLE_PUBLIC_H) */
@@ -23,4 +23,7 @@ typedef unsigned short u16;
 typedef int s32;
 typedef unsigned int u32;
 
+typedef long long s64;
+typedef unsigned long long u64;
+
 #endif /* !defined(TYPES_H) */
@@ -0,0 +1,124 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#include "zobrist.h"
+#include "bitops.h"
+#include "board.h"
+#include "common.h"
+#include "piece.h"
+#include "rules.h"
+#include "uassert.h"
+
+#include <stdlib.h>
+
+u64 g_zobrist_pieces[2][8][128];
+u64 g_zobrist_castling[16];
+u64 g_zobrist_en_passant[8];
+u64 g_zobrist_side;
+
+/* A xorshift64* generator. We use our own generator instead of rand(), so that the keys (and thus
+ * the search, which depends on them through the transposition table) are the same on every
+ * platform.
+ */
+static u64 random_u64(void)
+{
+    static u64 state = 0x9E3779B97F4A7C15ULL;
+
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Calculates the hash key of position 'pos' from scratch. During the search, the key is
+ * instead updated incrementally by make_move() and gupta_undo_move().
+ */
+u64 compute_hash_key(const gupta_position_t *pos)
+{
+    u64 key = 0;
+    int side;
+
+    for (side = 0; side < 2; side++)
+    {
+        int type;
+
+        for (type = PAWN; type <= QUEEN; type++)
+        {
+            u64 pieces;
+
+            for (pieces = pos->bitboards[side][type]; pieces; BB_CLEAR_LSB(pieces))
+                key ^= ZOBRIST_PIECE(side, type, SQ88(BB_LSB(pieces)));
+        }
+    }
+
+    key ^= zobrist_castling_key(pos->castling);
+    key ^= zobrist_en_passant_key(pos->en_passant);
+
+    if (pos->tside == BLACK)
+        key ^= g_zobrist_side;
+
+    return key;
+}
+
+void init_zobrist()
+{
+    size_t side,
+           type,
+           i;
+
+    for (side = 0; side < 2; side++)
+    {
+        for (type = 0; type < ARRAY_SIZE(g_zobrist_pieces[0]); type++)
+        {
+            for (i = 0; i < ARRAY_SIZE(g_zobrist_pieces[0][0]); i++)
+                g_zobrist_pieces[side][type][i] = random_u64();
+        }
+    }
+
+    for (i = 0; i < ARRAY_SIZE(g_zobrist_castling); i++)
+        g_zobrist_castling[i] = random_u64();
+
+    for (i = 0; i < ARRAY_SIZE(g_zobrist_en_passant); i++)
+        g_zobrist_en_passant[i] = random_u64();
+
+    g_zobrist_side = random_u64();
+}
+
+/* Returns the key for the castling availabilities expressed by the castling bits. Positions that
+ * differ only in bits that don't influence which castling moves are available (for example, the
+ * king of a side that can't castle anyway has moved) get the same key.
+ */
+u64 zobrist_castling_key(u8 castling)
+{
+    int index = 0;
+
+    if (BITS_ARE_ALL_CLEAR(castling, g_castling_masks[WHITE][0]))
+        index |= 1 << 0;
+    if (BITS_ARE_ALL_CLEAR(castling, g_castling_masks[WHITE][1]))
+        index |= 1 << 1;
+    if (BITS_ARE_ALL_CLEAR(castling, g_castling_masks[BLACK][0]))
+        index |= 1 << 2;
+    if (BITS_ARE_ALL_CLEAR(castling, g_castling_masks[BLACK][1]))
+        index |= 1 << 3;
+
+    return g_zobrist_castling[index];
+}
+
+u64 zobrist_en_passant_key(u8 en_passant)
+{
+    if (en_passant == 0x88)
+        return 0;
+
+    UASSERT((en_passant & 0x88) == 0);
+    return g_zobrist_en_passant[en_passant & 0x07];
+}
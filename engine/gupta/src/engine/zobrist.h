@@ -0,0 +1,38 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "board_public.h"
+#include "types.h"
+
+/* Random keys for Zobrist hashing. A position's hash key is the XOR of the keys of all its
+ * features (pieces on squares, castling availability, En Passant file and the side to move), so
+ * that making a move only requires XOR-ing the keys of the features that changed.
+ *
+ * 'g_zobrist_pieces' is indexed by side, piece type and 0x88 board location.
+ */
+extern u64 g_zobrist_pieces[2][8][128];
+extern u64 g_zobrist_castling[16];
+extern u64 g_zobrist_en_passant[8];
+extern u64 g_zobrist_side;
+
+#define ZOBRIST_PIECE(side, type, location) (g_zobrist_pieces[(side)][(type)][(location)])
+
+u64 compute_hash_key(const gupta_position_t *pos);
+void init_zobrist(void);
+u64 zobrist_castling_key(u8 castling);
+u64 zobrist_en_passant_key(u8 en_passant);
+
+#endif /* !defined(ZOBRIST_H) */
@@ -0,0 +1,78 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Standalone perft program, for measuring and verifying the move generator without the CECP
+ * interface.
+ *
+ * Usage:
+ *   gupta-perft [DEPTH]
+ *     Run the built-in suite of perft positions, to DEPTH plies if given.
+ *   gupta-perft DEPTH FEN
+ *     Show the node count of each move from the position FEN, to DEPTH plies.
+ */
+
+#include "engine/gupta.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char *argv[])
+{
+    int depth = 0,
+        r = 1;
+
+    /* Disable standard output buffering. */
+    setbuf(stdout, NULL);
+
+    if (argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [DEPTH [FEN]]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 1)
+    {
+        depth = atoi(argv[1]);
+        if ((depth < 1) || (depth > GUPTA_SEARCH_DEPTH_MAX))
+        {
+            fprintf(stderr, "Invalid depth '%s', must be between 1 and %d.\n", argv[1],
+                    GUPTA_SEARCH_DEPTH_MAX);
+            return 1;
+        }
+    }
+
+    gupta_init();
+
+    if (argc == 3)
+    {
+        gupta_position_t *pos = gupta_create_position();
+
+        if (!gupta_set_board_from_fen(pos, argv[2]))
+            fprintf(stderr, "Invalid position, '%s'.\n", argv[2]);
+        else
+        {
+            gupta_show_perft(pos, (size_t)depth, 1);
+            r = 0;
+        }
+
+        gupta_destroy_position(pos);
+    }
+    else
+        r = !gupta_run_perft_suite((size_t)depth);
+
+    gupta_uninit();
+
+    return r;
+}
@@ -0,0 +1,109 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * Standalone program that generates the endgame tablebases (see 'src/engine/tablebase.c'). The
+ * tables are generated in order, as every table looks up the tables that its captures and
+ * promotions lead to.
+ *
+ * Usage:
+ *   gupta-tablebase [-d DIRECTORY] [TABLE...]
+ *     Generate the tables named TABLE (for example 'KQK'), or all of them if none are named, in
+ *     the existing directory DIRECTORY ('gupta-tablebases' by default). The tables that a named
+ *     table depends on have to be generated already.
+ */
+
+#include "engine/gupta.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static int is_table_wanted(const char *name, int argc, char *argv[], int first_arg)
+{
+    int i;
+
+    if (first_arg >= argc)
+        return 1;
+
+    for (i = first_arg; i < argc; i++)
+    {
+        if (!strcmp(argv[i], name))
+            return 1;
+    }
+    return 0;
+}
+
+static void show_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-d DIRECTORY] [TABLE...]\n", program);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *path = GUPTA_TABLEBASE_PATH_DEFAULT;
+    size_t num_tables,
+           num_generated = 0,
+           idx;
+    int i = 1,
+        r = 1;
+
+    if ((argc > 1) && (argv[1][0] == '-'))
+    {
+        if (strcmp(argv[1], "-d") || (argc < 3))
+        {
+            show_usage(argv[0]);
+            return 1;
+        }
+        path = argv[2];
+        i = 3;
+    }
+
+    gupta_init();
+    num_tables = gupta_get_num_tablebases();
+
+    for (idx = 0; idx < num_tables; idx++)
+    {
+        const char *name = gupta_get_tablebase_name(idx);
+        gupta_tablebase_stats_t stats;
+
+        if (!is_table_wanted(name, argc, argv, i))
+            continue;
+
+        printf("%s: ", name);
+        fflush(stdout);
+        if (!gupta_generate_tablebase(path, idx, &stats))
+        {
+            printf("failed.\n");
+            fprintf(stderr, "Could not generate '%s' in '%s', are the tables it depends on "
+                    "there?\n", name, path);
+            goto done;
+        }
+        printf("%lu wins, %lu draws, %lu losses, longest mate %lu plies.\n",
+               (unsigned long)stats.num_wins, (unsigned long)stats.num_draws,
+               (unsigned long)stats.num_losses, (unsigned long)stats.longest_mate);
+        num_generated++;
+    }
+
+    if (num_generated == 0)
+    {
+        fprintf(stderr, "No such table.\n");
+        goto done;
+    }
+    r = 0;
+
+done:
+    gupta_uninit();
+
+    return r;
+}
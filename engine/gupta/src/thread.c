@@ -0,0 +1,186 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+/*
+ * A thin layer over the threads, mutexes and condition variables of the operating system, POSIX
+ * threads or Win32 threads (the condition variables of which require Windows Vista).
+ */
+
+#include "thread.h"
+#include "enforce.h"
+#include "uassert.h"
+
+#ifdef _WIN32
+static DWORD WINAPI thread_start(LPVOID arg)
+{
+    thread_t *thread = arg;
+
+    thread->func(thread->arg);
+    return 0;
+}
+#else /* !defined(_WIN32) */
+static void *thread_start(void *arg)
+{
+    thread_t *thread = arg;
+
+    thread->func(thread->arg);
+    return NULL;
+}
+#endif /* !defined(_WIN32) */
+
+/* Starts a thread that calls func(arg). The thread must be waited for with thread_join(), and
+ * 'thread' must remain valid until then. Returns 0 if the thread couldn't be started.
+ */
+int thread_create(thread_t *thread, thread_func_t func, void *arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, thread_start, thread, 0, NULL);
+    return thread->handle != NULL;
+#else /* !defined(_WIN32) */
+    return pthread_create(&thread->handle, NULL, thread_start, thread) == 0;
+#endif /* !defined(_WIN32) */
+}
+
+/* Waits for a thread started by thread_create() to finish. */
+void thread_join(thread_t *thread)
+{
+#ifdef _WIN32
+    DWORD r;
+
+    r = WaitForSingleObject(thread->handle, INFINITE);
+    UASSERT(r == WAIT_OBJECT_0);
+    (void)r;
+    CloseHandle(thread->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_join(thread->handle, NULL);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
+
+void mutex_init(mutex_t *mutex)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(&mutex->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_mutex_init(&mutex->handle, NULL);
+    enforce(r == 0);
+#endif /* !defined(_WIN32) */
+}
+
+void mutex_destroy(mutex_t *mutex)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(&mutex->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_mutex_destroy(&mutex->handle);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
+
+void mutex_lock(mutex_t *mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(&mutex->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_mutex_lock(&mutex->handle);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
+
+void mutex_unlock(mutex_t *mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(&mutex->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_mutex_unlock(&mutex->handle);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
+
+void cond_init(cond_t *cond)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(&cond->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_cond_init(&cond->handle, NULL);
+    enforce(r == 0);
+#endif /* !defined(_WIN32) */
+}
+
+void cond_destroy(cond_t *cond)
+{
+#ifdef _WIN32
+    /* Win32 condition variables need no cleanup. */
+    (void)cond;
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_cond_destroy(&cond->handle);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
+
+/* Unlocks 'mutex', which must be locked, and blocks until 'cond' is signaled, after which 'mutex'
+ * is locked again. As the wait may also end spuriously, the caller must recheck the condition it
+ * is waiting for.
+ */
+void cond_wait(cond_t *cond, mutex_t *mutex)
+{
+#ifdef _WIN32
+    BOOL r;
+
+    r = SleepConditionVariableCS(&cond->handle, &mutex->handle, INFINITE);
+    UASSERT(r);
+    (void)r;
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_cond_wait(&cond->handle, &mutex->handle);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
+
+void cond_signal(cond_t *cond)
+{
+#ifdef _WIN32
+    WakeConditionVariable(&cond->handle);
+#else /* !defined(_WIN32) */
+    int r;
+
+    r = pthread_cond_signal(&cond->handle);
+    UASSERT(r == 0);
+    (void)r;
+#endif /* !defined(_WIN32) */
+}
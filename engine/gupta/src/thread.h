@@ -0,0 +1,69 @@
+/*
+    Written by Jelle Geerts (jellegeerts@gmail.com).
+
+    To the extent possible under law, the author(s) have dedicated all
+    copyright and related and neighboring rights to this software to
+    the public domain worldwide. This software is distributed without
+    any warranty.
+
+    You should have received a copy of the CC0 Public Domain Dedication
+    along with this software.
+    If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
+
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#ifdef _WIN32
+#include <windows.h>
+#else /* !defined(_WIN32) */
+#include <pthread.h>
+#endif /* !defined(_WIN32) */
+
+typedef void (*thread_func_t)(void *arg);
+
+/* A thread of execution, see thread_create(). */
+typedef struct
+{
+#ifdef _WIN32
+    HANDLE handle;
+#else /* !defined(_WIN32) */
+    pthread_t handle;
+#endif /* !defined(_WIN32) */
+    thread_func_t func;
+    void *arg;
+} thread_t;
+
+typedef struct
+{
+#ifdef _WIN32
+    CRITICAL_SECTION handle;
+#else /* !defined(_WIN32) */
+    pthread_mutex_t handle;
+#endif /* !defined(_WIN32) */
+} mutex_t;
+
+typedef struct
+{
+#ifdef _WIN32
+    CONDITION_VARIABLE handle;
+#else /* !defined(_WIN32) */
+    pthread_cond_t handle;
+#endif /* !defined(_WIN32) */
+} cond_t;
+
+int thread_create(thread_t *thread, thread_func_t func, void *arg);
+void thread_join(thread_t *thread);
+
+void mutex_init(mutex_t *mutex);
+void mutex_destroy(mutex_t *mutex);
+void mutex_lock(mutex_t *mutex);
+void mutex_unlock(mutex_t *mutex);
+
+void cond_init(cond_t *cond);
+void cond_destroy(cond_t *cond);
+void cond_wait(cond_t *cond, mutex_t *mutex);
+void cond_signal(cond_t *cond);
+
+#endif /* !defined(THREAD_H) */